@@ -337,7 +337,8 @@ static void _set_timer_period(account_t account, uint32_t period)
             account->priv.timer = NULL;
         }
         if(period) {
-            account->priv.timer = soft_timer_create(account->id, SFTIM_MODE_REPEAT, period, account, _timer_callback_handler);
+            account->priv.timer = soft_timer_init_static(&account->priv.timer_storage, account->id, SFTIM_MODE_REPEAT,
+                                                         period, 0, account, _timer_callback_handler);
         }
     }
 }
@@ -25,15 +25,47 @@
 #include "data_center.h"
 #include "options.h"
 #include <string.h>
+#ifdef CONFIG_DATA_CENTER_USE_MEM_POOL
+#include "mem_pool.h"
+#endif
 
 /*---------- macro ----------*/
 #define TAG                                     "DataCenter"
 
+#ifndef CONFIG_DATA_CENTER_POOL_CHUNK_COUNT
+#define CONFIG_DATA_CENTER_POOL_CHUNK_COUNT     (8)
+#endif
+
 /*---------- type define ----------*/
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
+#ifdef CONFIG_DATA_CENTER_USE_MEM_POOL
+static mem_pool_t _node_pool;               /*<< Fixed-size pool of account nodes shared by all data centers */
+#endif
+
 /*---------- function ----------*/
+static struct account_node *_node_alloc(void)
+{
+#ifdef CONFIG_DATA_CENTER_USE_MEM_POOL
+    mem_pool_t pool = mem_pool_get_or_create(&_node_pool, sizeof(struct account_node),
+                                             CONFIG_DATA_CENTER_POOL_CHUNK_COUNT);
+
+    return (pool ? mem_pool_alloc(pool) : NULL);
+#else
+    return __malloc(sizeof(struct account_node));
+#endif
+}
+
+static void _node_free(struct account_node *p)
+{
+#ifdef CONFIG_DATA_CENTER_USE_MEM_POOL
+    mem_pool_free(_node_pool, p);
+#else
+    __free(p);
+#endif
+}
+
 static bool inline __match_by_name(const char *s1, const char *s2)
 {
     return (strcmp(s1, s2) == 0);
@@ -76,7 +108,7 @@ static bool _add_account(data_center_t center, account_t account)
             xlog_tag_error(TAG, "multi add Account(%s)\n", account->id);
             break;
         }
-        p = __malloc(sizeof(struct account_node));
+        p = _node_alloc();
         if(p == NULL) {
             xlog_tag_error(TAG, "alloc memory for Account(%s) to add account pool failed\n", account->id);
             break;
@@ -107,7 +139,7 @@ static bool _remove(struct list_head *pool, account_t account)
             if(__match_by_name(p->account->id, account->id) == true) {
                 xlog_tag_info(TAG, "remove account(%s) from account pool at 0x%p ok\n", account->id, p);
                 list_del(&p->node);
-                __free(p);
+                _node_free(p);
                 retval = true;
                 break;
             }
@@ -169,7 +201,7 @@ void data_center_deinit(data_center_t center)
     list_for_each_entry_safe(p, n, struct account_node, &center->account_pool, node) {
         account_destroy(p->account);
         list_del(&p->node);
-        __free(p);
+        _node_free(p);
     }
     /* delete main account */
     account_destroy(&center->account_main);
@@ -82,6 +82,7 @@ struct account {
     struct {
         account_event_cb_t event_cb;
         timer_handle_t timer;
+        struct timer_tcb timer_storage;     /*<< The timer is placed here, no heap is used */
         struct pingpong_buffer buffer_manager;
         uint32_t buffer_size;
     } priv;
@@ -23,10 +23,12 @@
 /*---------- includes ----------*/
 #include "heap.h"
 #include <stdlib.h>
+#include <string.h>
 #ifdef CONFIG_HEAP_FILE
 #include CONFIG_HEAP_FILE
 #endif
 
+#ifndef CONFIG_HEAP_USE_TLSF
 /*---------- macro ----------*/
 /* heap protect callback defition */
 #ifndef CONFIG_HEAP_LOCK
@@ -51,11 +53,26 @@
 #error "Please define the head total size before use this heap program"
 #endif
 
+#ifndef CONFIG_HEAP_REGION_MAX
+#define CONFIG_HEAP_REGION_MAX          (3)
+#endif
+
+#if (CONFIG_HEAP_REGION_MAX < 1) || (CONFIG_HEAP_REGION_MAX > 32)
+#error "CONFIG_HEAP_REGION_MAX must be in range 1 to 32"
+#endif
+
 /* Assumes 8bit bytes! */
 #define HEAP_BITS_PER_BYTE              ((size_t)8)
 /* Block sizes must not get too small. */
 #define HEAP_MINIMUM_BLOCK_SIZE         ((size_t)(heap_struct_size << 1))
 
+/* The return address of the public API is recorded by the heap tracer. */
+#if defined(__GNUC__)
+#define HEAP_CALLER()                   __builtin_return_address(0)
+#else
+#define HEAP_CALLER()                   NULL
+#endif
+
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- type define ----------*/
@@ -64,14 +81,23 @@ typedef struct a_block_link {
     size_t block_size;                      /*<< The size of the free block. */
 } block_link_t;
 
+typedef struct a_heap_region {
+    block_link_t start;                     /*<< The list head of the free blocks in the region. */
+    block_link_t *pend;                     /*<< Marks the end of the region. */
+    uint8_t *pbase;                         /*<< The first block of the region. */
+    size_t free_bytes_remaining;
+    size_t minimum_free_bytes_remaining;
+} heap_region_t;
+
 /*---------- variable ----------*/
 /* Allocate the memory for the heap. */
 static uint8_t heap[CONFIG_HEAP_TOTAL_SIZE];
 /* The size of the structure placed at the beginning of each allocated memory
  * block must by correctly byte aligned. */
 static const size_t heap_struct_size = (sizeof(block_link_t) + ((size_t)(CONFIG_HEAP_BYTE_ALIGNMENT - 1))) & ~((size_t)HEAP_BYTE_ALIGNMENT_MASK);
-/* Create a couple of list links to mark the start and end of the list. */
-static block_link_t start, *pend = NULL;
+/* Region 0 is the heap array above, others are added by heap_add_region(). */
+static heap_region_t regions[CONFIG_HEAP_REGION_MAX];
+static uint32_t region_count = 0;
 /* Keeps track of the number of calls to allocate and free memory as well as the
  * number of free bytes remaining, but says nothing about fragmentation. */
 static size_t free_bytes_remaining = 0U;
@@ -81,52 +107,91 @@ static size_t minimum_free_bytes_remaining = 0U;
  * application.  When the bit is free the block is still part of the free heap
  * space. */
 static size_t block_allocate_bit = 0;
+/* The bit below it is set in an allocated block which was aligned by
+ * heap_malloc_aligned(), the thread cache does not take such a block. */
+static size_t block_aligned_bit = 0;
 
 /*---------- function ----------*/
-static void heap_init(void)
+static bool heap_region_init(heap_region_t *pregion, void *pstart, size_t total_heap_size)
 {
     block_link_t *pblock_first_free = NULL;
     uint8_t *paligned_heap = NULL;
     size_t address = 0;
-    size_t total_heap_size = CONFIG_HEAP_TOTAL_SIZE;
+    bool retval = false;
 
-    address = (size_t)heap;
+    address = (size_t)pstart;
     if(0 != (address & HEAP_BYTE_ALIGNMENT_MASK)) {
         address += (CONFIG_HEAP_BYTE_ALIGNMENT - 1);
         address &= ~((size_t)HEAP_BYTE_ALIGNMENT_MASK);
-        total_heap_size -= address - (size_t)heap;
-    }
-    paligned_heap = (uint8_t *)address;
-    /* xStart is used to hold a pointer to the first item in the list of free
-     * blocks.  The void cast is used to prevent compiler warnings. */
-    start.pnext_free_block = (void *)paligned_heap;
-    start.block_size = (size_t)0;
-    /* pxEnd is used to mark the end of the list of free blocks and is inserted
-     * at the end of the heap space. */
-    address = ((size_t)paligned_heap) + total_heap_size;
-    address -= heap_struct_size;
-    address &= ~((size_t)HEAP_BYTE_ALIGNMENT_MASK);
-    pend = (void *)address;
-    pend->block_size = 0;
-    pend->pnext_free_block = NULL;
-    /* To start with there is a single free block that is sized to take up the
-     * entire heap space, minus the space taken by pxEnd. */
-    pblock_first_free = (void *)paligned_heap;
-    pblock_first_free->block_size = address - (size_t)pblock_first_free;
-    pblock_first_free->pnext_free_block = pend;
-    /* Only one block exists - and it covers the entire usable heap space. */
-    free_bytes_remaining = pblock_first_free->block_size;
-    minimum_free_bytes_remaining = pblock_first_free->block_size;
+        total_heap_size = ((address - (size_t)pstart) < total_heap_size) ?
+                          (total_heap_size - (address - (size_t)pstart)) : 0;
+    }
+    if(total_heap_size >= (heap_struct_size + HEAP_MINIMUM_BLOCK_SIZE + CONFIG_HEAP_BYTE_ALIGNMENT)) {
+        paligned_heap = (uint8_t *)address;
+        /* xStart is used to hold a pointer to the first item in the list of free
+         * blocks.  The void cast is used to prevent compiler warnings. */
+        pregion->start.pnext_free_block = (void *)paligned_heap;
+        pregion->start.block_size = (size_t)0;
+        pregion->pbase = paligned_heap;
+        /* pxEnd is used to mark the end of the list of free blocks and is inserted
+         * at the end of the heap space. */
+        address = ((size_t)paligned_heap) + total_heap_size;
+        address -= heap_struct_size;
+        address &= ~((size_t)HEAP_BYTE_ALIGNMENT_MASK);
+        pregion->pend = (void *)address;
+        pregion->pend->block_size = 0;
+        pregion->pend->pnext_free_block = NULL;
+        /* To start with there is a single free block that is sized to take up the
+         * entire heap space, minus the space taken by pxEnd. */
+        pblock_first_free = (void *)paligned_heap;
+        pblock_first_free->block_size = address - (size_t)pblock_first_free;
+        pblock_first_free->pnext_free_block = pregion->pend;
+        /* Only one block exists - and it covers the entire usable heap space. */
+        pregion->free_bytes_remaining = pblock_first_free->block_size;
+        pregion->minimum_free_bytes_remaining = pblock_first_free->block_size;
+        free_bytes_remaining += pblock_first_free->block_size;
+        minimum_free_bytes_remaining += pblock_first_free->block_size;
+        retval = true;
+    }
+
+    return retval;
+}
+
+static void heap_init(void)
+{
     /* Work out the position of the top bit in a size_t variable. */
     block_allocate_bit = ((size_t)1) << ((sizeof(size_t) * HEAP_BITS_PER_BYTE) - 1);
+    block_aligned_bit = block_allocate_bit >> 1;
+    if(heap_region_init(&regions[0], heap, CONFIG_HEAP_TOTAL_SIZE)) {
+        region_count = 1;
+    }
+}
+
+static inline size_t heap_block_size(const block_link_t *pblock)
+{
+    return pblock->block_size & ~(block_allocate_bit | block_aligned_bit);
 }
 
-static void heap_insert_block_into_free_list(block_link_t *pblock_insert)
+static heap_region_t *heap_find_region(const void *p)
+{
+    heap_region_t *pregion = NULL;
+
+    for(uint32_t i = 0; i < region_count; ++i) {
+        if((const uint8_t *)p >= regions[i].pbase && (const uint8_t *)p < (const uint8_t *)regions[i].pend) {
+            pregion = &regions[i];
+            break;
+        }
+    }
+
+    return pregion;
+}
+
+static void heap_insert_block_into_free_list(heap_region_t *pregion, block_link_t *pblock_insert)
 {
     block_link_t *pinterator = NULL;
     uint8_t *p = NULL;
 
-    for(pinterator = &start; pinterator->pnext_free_block < pblock_insert; 
+    for(pinterator = &pregion->start; pinterator->pnext_free_block < pblock_insert; 
         pinterator = pinterator->pnext_free_block) {
     }
     p = (uint8_t *)pinterator;
@@ -136,11 +201,11 @@ static void heap_insert_block_into_free_list(block_link_t *pblock_insert)
     }
     p = (uint8_t *)pblock_insert;
     if((p + pblock_insert->block_size) == (uint8_t *)pinterator->pnext_free_block) {
-        if(pinterator->pnext_free_block != pend) {
+        if(pinterator->pnext_free_block != pregion->pend) {
             pblock_insert->block_size += pinterator->pnext_free_block->block_size;
             pblock_insert->pnext_free_block = pinterator->pnext_free_block->pnext_free_block;
         } else {
-            pblock_insert->pnext_free_block = pend;
+            pblock_insert->pnext_free_block = pregion->pend;
         }
     } else {
         pblock_insert->pnext_free_block = pinterator->pnext_free_block;
@@ -150,88 +215,409 @@ static void heap_insert_block_into_free_list(block_link_t *pblock_insert)
     }
 }
 
-void *heap_malloc(size_t wanted_size)
+static size_t heap_block_align_offset(block_link_t *pblock, size_t alignment)
+{
+    size_t address = (size_t)pblock + heap_struct_size;
+    size_t offset = ((address + alignment - 1) & ~(alignment - 1)) - address;
+
+    /* The padding in front of the aligned block is returned to the free list,
+     * so it must be big enough to be a block itself. */
+    while((0 != offset) && (offset < HEAP_MINIMUM_BLOCK_SIZE)) {
+        offset += alignment;
+    }
+
+    return offset;
+}
+
+static void *heap_region_malloc(heap_region_t *pregion, size_t wanted_size, size_t alignment)
 {
     block_link_t *pblock = NULL, *pblock_previous = NULL, *pblock_new = NULL;
     void *preturn = NULL;
+    size_t offset = 0;
+
+    if(wanted_size <= pregion->free_bytes_remaining) {
+        /* Traverse the list from the start	(lowest address) block until
+         * one	of adequate size is found. */
+        pblock_previous = &pregion->start;
+        pblock = pregion->start.pnext_free_block;
+        while(pblock != pregion->pend) {
+            offset = (0 != alignment) ? heap_block_align_offset(pblock, alignment) : 0;
+            if(pblock->block_size >= (wanted_size + offset)) {
+                break;
+            }
+            pblock_previous = pblock;
+            pblock = pblock->pnext_free_block;
+        }
+        if(pblock != pregion->pend) {
+            if(0 != offset) {
+                /* Keep the alignment padding in the free list and allocate
+                 * the aligned block behind it. */
+                pblock_new = (void *)(((uint8_t *)pblock) + offset);
+                pblock_new->block_size = pblock->block_size - offset;
+                pblock_new->pnext_free_block = pblock->pnext_free_block;
+                pblock->block_size = offset;
+                pblock->pnext_free_block = pblock_new;
+                pblock_previous = pblock;
+                pblock = pblock_new;
+            }
+            preturn = (void *)(((uint8_t *)pblock_previous->pnext_free_block) + heap_struct_size);
+            pblock_previous->pnext_free_block = pblock->pnext_free_block;
+            /* If the block is larger than required it can be split into
+             * two. */
+            if((pblock->block_size - wanted_size) > HEAP_MINIMUM_BLOCK_SIZE) {
+                pblock_new = (void *)(((uint8_t *)pblock) + wanted_size);
+                pblock_new->block_size = pblock->block_size - wanted_size;
+                pblock->block_size = wanted_size;
+                heap_insert_block_into_free_list(pregion, pblock_new);
+            }
+            pregion->free_bytes_remaining -= pblock->block_size;
+            if(pregion->minimum_free_bytes_remaining > pregion->free_bytes_remaining) {
+                pregion->minimum_free_bytes_remaining = pregion->free_bytes_remaining;
+            }
+            free_bytes_remaining -= pblock->block_size;
+            if(minimum_free_bytes_remaining > free_bytes_remaining) {
+                minimum_free_bytes_remaining = free_bytes_remaining;
+            }
+            pblock->block_size |= block_allocate_bit | ((0 != alignment) ? block_aligned_bit : 0);
+            pblock->pnext_free_block = NULL;
+        }
+    }
+
+    return preturn;
+}
+
+int32_t heap_add_region(void *pstart, size_t size)
+{
+    int32_t region = -1;
 
     CONFIG_HEAP_LOCK();
     {
-        if(NULL == pend) {
+        if(0 == region_count) {
             heap_init();
         }
-        /* Check the requested block size is not so large that the top bit is
-         * set.  The top bit of the block size member of the BlockLink_t structure
-         * is used to determine who owns the block - the application or the
-         * kernel, so it must be free. */
-        if(0 == (wanted_size & block_allocate_bit)) {
-            if(0 < wanted_size) {
-                wanted_size += heap_struct_size;
-                /* Ensure that blocks are always aligned to the required number
-                 * of bytes. */
-                if(0x00 != (wanted_size & HEAP_BYTE_ALIGNMENT_MASK)) {
-                    wanted_size += (CONFIG_HEAP_BYTE_ALIGNMENT - (wanted_size & HEAP_BYTE_ALIGNMENT_MASK));
-                }
+        if(NULL != pstart && region_count < CONFIG_HEAP_REGION_MAX &&
+           heap_region_init(&regions[region_count], pstart, size)) {
+            region = (int32_t)region_count;
+            region_count++;
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+
+    return region;
+}
+
+static bool heap_region_resize(heap_region_t *pregion, block_link_t *pblock, size_t wanted_size)
+{
+    block_link_t *pblock_next = NULL, *pinterator = NULL, *pblock_new = NULL;
+    size_t block_size = heap_block_size(pblock);
+    bool retval = true;
+
+    if(wanted_size > block_size) {
+        /* Grow into the following block if it is free, the free list is sorted
+         * by address so its predecessor is found on the way. */
+        retval = false;
+        pblock_next = (void *)(((uint8_t *)pblock) + block_size);
+        for(pinterator = &pregion->start; pinterator->pnext_free_block < pblock_next;
+            pinterator = pinterator->pnext_free_block) {
+        }
+        if((pinterator->pnext_free_block == pblock_next) && (pblock_next != pregion->pend) &&
+           ((block_size + pblock_next->block_size) >= wanted_size)) {
+            pinterator->pnext_free_block = pblock_next->pnext_free_block;
+            pregion->free_bytes_remaining -= pblock_next->block_size;
+            free_bytes_remaining -= pblock_next->block_size;
+            block_size += pblock_next->block_size;
+            retval = true;
+        }
+    }
+    if(retval) {
+        /* Give the unused tail back to the free list. */
+        if((block_size - wanted_size) > HEAP_MINIMUM_BLOCK_SIZE) {
+            pblock_new = (void *)(((uint8_t *)pblock) + wanted_size);
+            pblock_new->block_size = block_size - wanted_size;
+            block_size = wanted_size;
+            pregion->free_bytes_remaining += pblock_new->block_size;
+            free_bytes_remaining += pblock_new->block_size;
+            heap_insert_block_into_free_list(pregion, pblock_new);
+        }
+        pblock->block_size = block_size | (pblock->block_size & block_aligned_bit) | block_allocate_bit;
+        if(pregion->minimum_free_bytes_remaining > pregion->free_bytes_remaining) {
+            pregion->minimum_free_bytes_remaining = pregion->free_bytes_remaining;
+        }
+        if(minimum_free_bytes_remaining > free_bytes_remaining) {
+            minimum_free_bytes_remaining = free_bytes_remaining;
+        }
+    }
+
+    return retval;
+}
+
+/* Must be called with the heap locked. */
+static void *heap_malloc_locked(uint32_t region_mask, size_t wanted_size, size_t alignment)
+{
+    void *preturn = NULL;
+
+    if(0 == region_count) {
+        heap_init();
+    }
+    /* Check the requested block size is not so large that the top bit is
+     * set.  The top bit of the block size member of the BlockLink_t structure
+     * is used to determine who owns the block - the application or the
+     * kernel, so it must be free. */
+    if(0 == (wanted_size & (block_allocate_bit | block_aligned_bit))) {
+        if(0 < wanted_size) {
+            wanted_size += heap_struct_size;
+            /* Ensure that blocks are always aligned to the required number
+             * of bytes. */
+            if(0x00 != (wanted_size & HEAP_BYTE_ALIGNMENT_MASK)) {
+                wanted_size += (CONFIG_HEAP_BYTE_ALIGNMENT - (wanted_size & HEAP_BYTE_ALIGNMENT_MASK));
             }
-            if((0 < wanted_size) && (wanted_size <= free_bytes_remaining)) {
-                /* Traverse the list from the start	(lowest address) block until
-                 * one	of adequate size is found. */
-                pblock_previous = &start;
-                pblock = start.pnext_free_block;
-                while((pblock->block_size < wanted_size) &&
-                      (pblock->pnext_free_block != NULL)) {
-                    pblock_previous = pblock;
-                    pblock = pblock->pnext_free_block;
-                }
-                if(pblock != pend) {
-                    preturn = (void *)(((uint8_t *)pblock_previous->pnext_free_block) + heap_struct_size);
-                    pblock_previous->pnext_free_block = pblock->pnext_free_block;
-                    /* If the block is larger than required it can be split into
-                     * two. */
-                    if((pblock->block_size - wanted_size) > HEAP_MINIMUM_BLOCK_SIZE) {
-                        pblock_new = (void *)(((uint8_t *)pblock) + wanted_size);
-                        pblock_new->block_size = pblock->block_size - wanted_size;
-                        pblock->block_size = wanted_size;
-                        heap_insert_block_into_free_list(pblock_new);
-                    }
-                    free_bytes_remaining -= pblock->block_size;
-                    if(minimum_free_bytes_remaining > free_bytes_remaining) {
-                        minimum_free_bytes_remaining = free_bytes_remaining;
-                    }
-                    pblock->block_size |= block_allocate_bit;
-                    pblock->pnext_free_block = NULL;
+        }
+        if((0 < wanted_size) && (wanted_size <= free_bytes_remaining)) {
+            /* Regions are tried in the order they were added. */
+            for(uint32_t i = 0; i < region_count && NULL == preturn; ++i) {
+                if(region_mask & HEAP_REGION_MASK(i)) {
+                    preturn = heap_region_malloc(&regions[i], wanted_size, alignment);
                 }
             }
         }
     }
+
+    return preturn;
+}
+
+static void *heap_malloc_common(uint32_t region_mask, size_t wanted_size, size_t alignment, void *caller)
+{
+    void *preturn = NULL;
+
+    CONFIG_HEAP_LOCK();
+    preturn = heap_malloc_locked(region_mask, wanted_size, alignment);
+    heap_stats_record((NULL != preturn) ? HEAP_TRACE_MALLOC : HEAP_TRACE_FAILED, caller, preturn, wanted_size);
     CONFIG_HEAP_UNLOCK();
 
     return preturn;
 }
 
+static void *heap_malloc_aligned_common(uint32_t region_mask, size_t wanted_size, size_t alignment, void *caller)
+{
+    void *preturn = NULL;
+
+    /* The alignment must be a power of two. */
+    if((0 != alignment) && (0 == (alignment & (alignment - 1)))) {
+        if(alignment <= CONFIG_HEAP_BYTE_ALIGNMENT) {
+            alignment = 0;
+        }
+        preturn = heap_malloc_common(region_mask, wanted_size, alignment, caller);
+    }
+
+    return preturn;
+}
+
+void *heap_malloc_in(uint32_t region_mask, size_t wanted_size)
+{
+    return heap_malloc_common(region_mask, wanted_size, 0, HEAP_CALLER());
+}
+
+void *heap_malloc(size_t wanted_size)
+{
+    void *preturn = NULL;
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+    preturn = heap_thread_cache_malloc(wanted_size, HEAP_CALLER());
+#endif
+    if(NULL == preturn) {
+        preturn = heap_malloc_common(HEAP_REGION_ANY, wanted_size, 0, HEAP_CALLER());
+    }
+
+    return preturn;
+}
+
+uint32_t heap_malloc_batch(size_t wanted_size, void **pptrs, uint32_t count)
+{
+    uint32_t allocated = 0;
+
+    CONFIG_HEAP_LOCK();
+    for(; allocated < count; ++allocated) {
+        pptrs[allocated] = heap_malloc_locked(HEAP_REGION_MASK(0), wanted_size, 0);
+        if(NULL == pptrs[allocated]) {
+            break;
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+
+    return allocated;
+}
+
+void *heap_malloc_aligned_in(uint32_t region_mask, size_t wanted_size, size_t alignment)
+{
+    return heap_malloc_aligned_common(region_mask, wanted_size, alignment, HEAP_CALLER());
+}
+
+void *heap_malloc_aligned(size_t wanted_size, size_t alignment)
+{
+    return heap_malloc_aligned_common(HEAP_REGION_ANY, wanted_size, alignment, HEAP_CALLER());
+}
+
+/* Must be called with the heap locked, the block has been checked by the caller.
+ * The payload size of the freed block is returned, 0 if it is not in a region. */
+static size_t heap_free_locked(void *pfree)
+{
+    block_link_t *plink = (void *)(((uint8_t *)pfree) - heap_struct_size);
+    heap_region_t *pregion = NULL;
+    size_t size = 0;
+
+    pregion = heap_find_region(plink);
+    if(NULL != pregion) {
+        /* The block is being returned to the heap - it is no longer
+         * allocated. */
+        plink->block_size &= ~(block_allocate_bit | block_aligned_bit);
+        /* Add this block to the list of free blocks. */
+        pregion->free_bytes_remaining += plink->block_size;
+        free_bytes_remaining += plink->block_size;
+        size = plink->block_size - heap_struct_size;
+        heap_insert_block_into_free_list(pregion, plink);
+    }
+
+    return size;
+}
+
+static bool heap_block_is_allocated(void *ptr)
+{
+    block_link_t *plink = (void *)(((uint8_t *)ptr) - heap_struct_size);
+
+    return ((0 != (plink->block_size & block_allocate_bit)) && (NULL == plink->pnext_free_block));
+}
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+/* The magazines are refilled from the built-in heap without alignment, so a block of
+ * another region or an aligned one is returned to its region at once. */
+static bool heap_block_is_cacheable(void *ptr)
+{
+    block_link_t *plink = (void *)(((uint8_t *)ptr) - heap_struct_size);
+
+    return (NULL != ptr && (uint8_t *)plink >= heap && (uint8_t *)plink < &heap[CONFIG_HEAP_TOTAL_SIZE] &&
+            heap_block_is_allocated(ptr) && 0 == (plink->block_size & block_aligned_bit));
+}
+#endif
+
+static void heap_free_common(void *pfree, void *caller)
+{
+    size_t size = 0;
+
+    if(NULL != pfree && heap_block_is_allocated(pfree)) {
+        CONFIG_HEAP_LOCK();
+        size = heap_free_locked(pfree);
+        if(0 != size) {
+            heap_stats_record(HEAP_TRACE_FREE, caller, pfree, size);
+        }
+        CONFIG_HEAP_UNLOCK();
+    }
+}
+
 void heap_free(void *pfree)
 {
-    uint8_t *p = (uint8_t *)pfree;
+    bool cached = false;
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+    cached = heap_block_is_cacheable(pfree) && heap_thread_cache_free(pfree, HEAP_CALLER());
+#endif
+    if(!cached) {
+        heap_free_common(pfree, HEAP_CALLER());
+    }
+}
+
+void heap_free_batch(void **pptrs, uint32_t count)
+{
+    CONFIG_HEAP_LOCK();
+    for(uint32_t i = 0; i < count; ++i) {
+        if(NULL != pptrs[i] && heap_block_is_allocated(pptrs[i])) {
+            (void)heap_free_locked(pptrs[i]);
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+}
+
+size_t heap_usable_size(void *ptr)
+{
     block_link_t *plink = NULL;
+    size_t size = 0;
+
+    if(NULL != ptr && heap_block_is_allocated(ptr)) {
+        plink = (void *)(((uint8_t *)ptr) - heap_struct_size);
+        size = heap_block_size(plink) - heap_struct_size;
+    }
 
-    if(NULL != pfree) {
-        p -= heap_struct_size;
-        plink = (void *)p;
-        if(0 != (plink->block_size & block_allocate_bit)) {
-            if(NULL == plink->pnext_free_block) {
-                /* The block is being returned to the heap - it is no longer
-                 * allocated. */
-                plink->block_size &= ~block_allocate_bit;
-                CONFIG_HEAP_LOCK();
-                {
-                    /* Add this block to the list of free blocks. */
-                    free_bytes_remaining += plink->block_size;
-                    heap_insert_block_into_free_list(plink);
+    return size;
+}
+
+void *heap_realloc(void *pold, size_t wanted_size)
+{
+    void *caller = HEAP_CALLER();
+    block_link_t *pblock = NULL;
+    heap_region_t *pregion = NULL;
+    void *preturn = NULL;
+    size_t block_size = 0, copy_size = 0;
+
+    if(NULL == pold) {
+        preturn = heap_malloc_common(HEAP_REGION_ANY, wanted_size, 0, caller);
+    } else if(0 == wanted_size) {
+        heap_free_common(pold, caller);
+    } else {
+        pblock = (void *)(((uint8_t *)pold) - heap_struct_size);
+        if((0 != (pblock->block_size & block_allocate_bit)) && (NULL == pblock->pnext_free_block) &&
+           (0 == (wanted_size & (block_allocate_bit | block_aligned_bit)))) {
+            block_size = wanted_size + heap_struct_size;
+            if(0x00 != (block_size & HEAP_BYTE_ALIGNMENT_MASK)) {
+                block_size += (CONFIG_HEAP_BYTE_ALIGNMENT - (block_size & HEAP_BYTE_ALIGNMENT_MASK));
+            }
+            CONFIG_HEAP_LOCK();
+            {
+                pregion = heap_find_region(pblock);
+                copy_size = heap_block_size(pblock) - heap_struct_size;
+                if(NULL != pregion && heap_region_resize(pregion, pblock, block_size)) {
+                    heap_stats_record(HEAP_TRACE_REALLOC, caller, pold, wanted_size);
+                    preturn = pold;
+                }
+            }
+            CONFIG_HEAP_UNLOCK();
+            /* The data is moved only when the block can not be resized in place. */
+            if(NULL == preturn && NULL != pregion) {
+                preturn = heap_malloc_common(HEAP_REGION_ANY, wanted_size, 0, caller);
+                if(NULL != preturn) {
+                    memcpy(preturn, pold, (copy_size < wanted_size) ? copy_size : wanted_size);
+                    heap_free_common(pold, caller);
                 }
-                CONFIG_HEAP_UNLOCK();
             }
         }
     }
+
+    return preturn;
+}
+
+void heap_walk(uint32_t region_mask, heap_walker_t walker, void *user_data)
+{
+    block_link_t *pblock = NULL;
+    size_t block_size = 0;
+
+    CONFIG_HEAP_LOCK();
+    {
+        if(0 == region_count) {
+            heap_init();
+        }
+        /* The blocks of a region are contiguous, so every block, used or free,
+         * is reached by its size. */
+        for(uint32_t i = 0; i < region_count && NULL != walker; ++i) {
+            if(0 == (region_mask & HEAP_REGION_MASK(i))) {
+                continue;
+            }
+            for(pblock = (void *)regions[i].pbase; pblock != regions[i].pend;
+                pblock = (void *)(((uint8_t *)pblock) + block_size)) {
+                block_size = heap_block_size(pblock);
+                walker(((uint8_t *)pblock) + heap_struct_size, block_size - heap_struct_size,
+                       (0 != (pblock->block_size & block_allocate_bit)), user_data);
+            }
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
 }
 
 size_t heap_get_free_remaining_size(void)
@@ -243,3 +629,14 @@ size_t heap_get_minimum_free_remaining_size(void)
 {
     return minimum_free_bytes_remaining;
 }
+
+size_t heap_get_region_free_remaining_size(uint32_t region)
+{
+    return (region < region_count) ? regions[region].free_bytes_remaining : 0;
+}
+
+size_t heap_get_region_minimum_free_remaining_size(uint32_t region)
+{
+    return (region < region_count) ? regions[region].minimum_free_bytes_remaining : 0;
+}
+#endif
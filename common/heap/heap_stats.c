@@ -0,0 +1,157 @@
+/**
+ * @file heap_stats.c
+ *
+ * Copyright (C) 2024
+ *
+ * heap_stats.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note shared by the first fit and the TLSF engine
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <string.h>
+#ifdef CONFIG_HEAP_FILE
+#include CONFIG_HEAP_FILE
+#endif
+
+/*---------- macro ----------*/
+/* heap protect callback defition */
+#ifndef CONFIG_HEAP_LOCK
+#define CONFIG_HEAP_LOCK()
+#endif
+
+#ifndef CONFIG_HEAP_UNLOCK
+#define CONFIG_HEAP_UNLOCK()
+#endif
+
+/* The timestamp of the trace records, e.g. a tick counter or a cycle counter. */
+#ifndef CONFIG_HEAP_TRACE_TIMESTAMP
+#define CONFIG_HEAP_TRACE_TIMESTAMP()   (0)
+#endif
+
+#define HEAP_STATS_HISTOGRAM_SHIFT      (4)
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- type define ----------*/
+/*---------- variable ----------*/
+static uint32_t alloc_count = 0;
+static uint32_t free_count = 0;
+static uint32_t failed_count = 0;
+
+#ifdef CONFIG_HEAP_TRACE_DEPTH
+static struct heap_trace_record trace_ring[CONFIG_HEAP_TRACE_DEPTH];
+/* trace_head is the slot of the next record, trace_count the number of valid records. */
+static uint32_t trace_head = 0;
+static uint32_t trace_count = 0;
+#endif
+
+/*---------- function ----------*/
+static void heap_stats_walker(void *ptr, size_t size, bool used, void *user_data)
+{
+    heap_stats_t stats = (heap_stats_t)user_data;
+    uint32_t bin = 0;
+    size_t bucket = size >> (HEAP_STATS_HISTOGRAM_SHIFT + 1);
+
+    (void)ptr;
+    if(used) {
+        stats->used_block_count++;
+    } else {
+        stats->free_block_count++;
+        stats->free_bytes += size;
+        if(stats->largest_free_block < size) {
+            stats->largest_free_block = size;
+        }
+        while(bucket && bin < (HEAP_STATS_HISTOGRAM_SIZE - 1)) {
+            bucket >>= 1;
+            bin++;
+        }
+        stats->histogram[bin]++;
+    }
+}
+
+void heap_get_stats(uint32_t region_mask, heap_stats_t stats)
+{
+    if(NULL != stats) {
+        memset(stats, 0, sizeof(*stats));
+        heap_walk(region_mask, heap_stats_walker, stats);
+        if(0 != stats->free_bytes) {
+            stats->fragmentation = (uint32_t)(((uint64_t)(stats->free_bytes - stats->largest_free_block) * 100) /
+                                              stats->free_bytes);
+        }
+        CONFIG_HEAP_LOCK();
+        stats->alloc_count = alloc_count;
+        stats->free_count = free_count;
+        stats->failed_count = failed_count;
+        CONFIG_HEAP_UNLOCK();
+    }
+}
+
+void heap_stats_record(heap_trace_op_t op, void *caller, void *ptr, size_t size)
+{
+#ifdef CONFIG_HEAP_TRACE_DEPTH
+    heap_trace_record_t precord = &trace_ring[trace_head];
+#endif
+
+    if(HEAP_TRACE_MALLOC == op) {
+        alloc_count++;
+    } else if(HEAP_TRACE_FREE == op) {
+        free_count++;
+    } else if(HEAP_TRACE_FAILED == op) {
+        failed_count++;
+    }
+#ifdef CONFIG_HEAP_TRACE_DEPTH
+    precord->caller = caller;
+    precord->ptr = ptr;
+    precord->size = (uint32_t)size;
+    precord->timestamp = (uint32_t)CONFIG_HEAP_TRACE_TIMESTAMP();
+    precord->op = (uint8_t)op;
+    trace_head = (trace_head + 1) % CONFIG_HEAP_TRACE_DEPTH;
+    if(trace_count < CONFIG_HEAP_TRACE_DEPTH) {
+        trace_count++;
+    }
+#else
+    (void)caller;
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+uint32_t heap_trace_read(heap_trace_record_t records, uint32_t count)
+{
+    uint32_t copied = 0;
+
+#ifdef CONFIG_HEAP_TRACE_DEPTH
+    uint32_t index = 0;
+
+    if(NULL != records) {
+        CONFIG_HEAP_LOCK();
+        copied = (count < trace_count) ? count : trace_count;
+        /* Skip the records which do not fit, so the latest ones are returned. */
+        index = (trace_head + CONFIG_HEAP_TRACE_DEPTH - copied) % CONFIG_HEAP_TRACE_DEPTH;
+        for(uint32_t i = 0; i < copied; ++i) {
+            records[i] = trace_ring[index];
+            index = (index + 1) % CONFIG_HEAP_TRACE_DEPTH;
+        }
+        CONFIG_HEAP_UNLOCK();
+    }
+#else
+    (void)records;
+    (void)count;
+#endif
+
+    return copied;
+}
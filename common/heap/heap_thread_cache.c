@@ -0,0 +1,234 @@
+/**
+ * @file heap_thread_cache.c
+ *
+ * Copyright (C) 2024
+ *
+ * heap_thread_cache.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note per-thread magazines in front of the first fit or the TLSF engine,
+ * only for the POSIX host build
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <string.h>
+#ifdef CONFIG_HEAP_FILE
+#include CONFIG_HEAP_FILE
+#endif
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+#include <pthread.h>
+
+/*---------- macro ----------*/
+/* heap protect callback defition */
+#ifndef CONFIG_HEAP_LOCK
+#define CONFIG_HEAP_LOCK()
+#endif
+
+#ifndef CONFIG_HEAP_UNLOCK
+#define CONFIG_HEAP_UNLOCK()
+#endif
+
+/* Size classes are 16, 32, 64 ... bytes, the default covers requests up to 2048 bytes. */
+#ifndef CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT
+#define CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT    (8)
+#endif
+
+/* The number of blocks a magazine can hold, half of them are moved per refill or flush. */
+#ifndef CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE
+#define CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE  (32)
+#endif
+
+#if (CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE < 2)
+#error "CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE must be at least 2"
+#endif
+
+#define HEAP_THREAD_CACHE_CLASS_SHIFT           (4)
+#define HEAP_THREAD_CACHE_CLASS_SIZE(c)         (((size_t)1) << ((c) + HEAP_THREAD_CACHE_CLASS_SHIFT))
+#define HEAP_THREAD_CACHE_BATCH                 (CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE / 2)
+
+/*---------- type define ----------*/
+struct magazine {
+    uint32_t count;
+    void *objects[CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE];
+};
+
+struct thread_cache {
+    bool registered;
+    bool exited;                /*<< Flushed by the destructor, the heap is used directly */
+    uint32_t alloc_count;       /*<< Cached operations not yet added to the heap statistics */
+    uint32_t free_count;
+    struct magazine magazines[CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT];
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static _Thread_local struct thread_cache cache;
+/* Only used to flush the magazines when a thread exits. */
+static pthread_key_t cache_key;
+static pthread_once_t cache_key_once = PTHREAD_ONCE_INIT;
+
+/*---------- function ----------*/
+/* Add the counted operations to the heap statistics. */
+static void heap_thread_cache_sync(struct thread_cache *pcache)
+{
+    if(0 != pcache->alloc_count || 0 != pcache->free_count) {
+        CONFIG_HEAP_LOCK();
+        for(; 0 != pcache->alloc_count; --pcache->alloc_count) {
+            heap_stats_record(HEAP_TRACE_MALLOC, NULL, NULL, 0);
+        }
+        for(; 0 != pcache->free_count; --pcache->free_count) {
+            heap_stats_record(HEAP_TRACE_FREE, NULL, NULL, 0);
+        }
+        CONFIG_HEAP_UNLOCK();
+    }
+}
+
+/* The blocks moved between the heap and the magazines are not recorded by the heap,
+ * the blocks handed out and taken back by the magazines are recorded here instead. */
+static void heap_thread_cache_record(struct thread_cache *pcache, heap_trace_op_t op, void *caller, void *ptr,
+                                     size_t size)
+{
+#ifdef CONFIG_HEAP_TRACE_DEPTH
+    /* the tracer keeps every operation in order, so it is recorded at once */
+    (void)pcache;
+    CONFIG_HEAP_LOCK();
+    heap_stats_record(op, caller, ptr, size);
+    CONFIG_HEAP_UNLOCK();
+#else
+    /* only the counters are kept, they are added up once per batch */
+    (void)caller;
+    (void)ptr;
+    (void)size;
+    if(HEAP_TRACE_MALLOC == op) {
+        pcache->alloc_count++;
+    } else {
+        pcache->free_count++;
+    }
+    if((pcache->alloc_count + pcache->free_count) >= HEAP_THREAD_CACHE_BATCH) {
+        heap_thread_cache_sync(pcache);
+    }
+#endif
+}
+
+static void heap_thread_cache_flush_cache(struct thread_cache *pcache)
+{
+    for(uint32_t i = 0; i < CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT; ++i) {
+        heap_free_batch(pcache->magazines[i].objects, pcache->magazines[i].count);
+        pcache->magazines[i].count = 0;
+    }
+    heap_thread_cache_sync(pcache);
+}
+
+/* A block freed by a later TLS destructor of the thread would stay in a magazine which
+ * is never flushed again, so the thread bypasses the magazines from now on. */
+static void heap_thread_cache_destructor(void *arg)
+{
+    struct thread_cache *pcache = (struct thread_cache *)arg;
+
+    heap_thread_cache_flush_cache(pcache);
+    pcache->exited = true;
+}
+
+static void heap_thread_cache_key_create(void)
+{
+    pthread_key_create(&cache_key, heap_thread_cache_destructor);
+}
+
+static struct thread_cache *heap_thread_cache_get(void)
+{
+    if(!cache.registered) {
+        pthread_once(&cache_key_once, heap_thread_cache_key_create);
+        pthread_setspecific(cache_key, &cache);
+        cache.registered = true;
+    }
+
+    return &cache;
+}
+
+void *heap_thread_cache_malloc(size_t wanted_size, void *caller)
+{
+    struct thread_cache *pcache = NULL;
+    struct magazine *pmagazine = NULL;
+    void *preturn = NULL;
+    uint32_t c = 0;
+
+    /* Round up to the class which can hold the request. */
+    while(c < CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT && HEAP_THREAD_CACHE_CLASS_SIZE(c) < wanted_size) {
+        c++;
+    }
+    if(0 < wanted_size && c < CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT && !cache.exited) {
+        pcache = heap_thread_cache_get();
+        pmagazine = &pcache->magazines[c];
+        if(0 == pmagazine->count) {
+            pmagazine->count = heap_malloc_batch(HEAP_THREAD_CACHE_CLASS_SIZE(c), pmagazine->objects,
+                                                 HEAP_THREAD_CACHE_BATCH);
+            if(0 == pmagazine->count) {
+                /* The built-in heap is exhausted, the blocks cached in other classes
+                 * may help the heap which serves the request now. */
+                heap_thread_cache_flush_cache(pcache);
+            }
+        }
+        if(0 != pmagazine->count) {
+            preturn = pmagazine->objects[--pmagazine->count];
+            heap_thread_cache_record(pcache, HEAP_TRACE_MALLOC, caller, preturn, wanted_size);
+        }
+    }
+
+    return preturn;
+}
+
+bool heap_thread_cache_free(void *pfree, void *caller)
+{
+    struct thread_cache *pcache = NULL;
+    struct magazine *pmagazine = NULL;
+    size_t size = heap_usable_size(pfree);
+    uint32_t c = 0;
+    bool retval = false;
+
+    /* Round down to the class whose requests the block can serve. Blocks are not
+     * owned by the thread which allocated them, so a block freed by another thread
+     * simply enters the magazine of that thread without any lock. */
+    if(size >= HEAP_THREAD_CACHE_CLASS_SIZE(0)) {
+        while(c < CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT && HEAP_THREAD_CACHE_CLASS_SIZE(c + 1) <= size) {
+            c++;
+        }
+    } else {
+        c = CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT;
+    }
+    if(c < CONFIG_HEAP_THREAD_CACHE_CLASS_COUNT && !cache.exited) {
+        pcache = heap_thread_cache_get();
+        pmagazine = &pcache->magazines[c];
+        if(CONFIG_HEAP_THREAD_CACHE_MAGAZINE_SIZE == pmagazine->count) {
+            /* Flush the oldest blocks, the latest ones are still hot in the cache. */
+            heap_free_batch(pmagazine->objects, HEAP_THREAD_CACHE_BATCH);
+            pmagazine->count -= HEAP_THREAD_CACHE_BATCH;
+            memmove(pmagazine->objects, &pmagazine->objects[HEAP_THREAD_CACHE_BATCH],
+                    pmagazine->count * sizeof(pmagazine->objects[0]));
+        }
+        pmagazine->objects[pmagazine->count++] = pfree;
+        heap_thread_cache_record(pcache, HEAP_TRACE_FREE, caller, pfree, size);
+        retval = true;
+    }
+
+    return retval;
+}
+
+void heap_thread_cache_flush(void)
+{
+    heap_thread_cache_flush_cache(heap_thread_cache_get());
+}
+#endif
@@ -0,0 +1,803 @@
+/**
+ * @file heap_tlsf.c
+ *
+ * Copyright (C) 2020
+ *
+ * heap_tlsf.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note Two-Level Segregated Fit allocator, reference from M. Masmano,
+ * I. Ripoll, A. Crespo and J. Real "TLSF: a new dynamic memory allocator
+ * for real-time systems". Define CONFIG_HEAP_USE_TLSF to use this engine
+ * instead of the first-fit engine in heap.c.
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef CONFIG_HEAP_FILE
+#include CONFIG_HEAP_FILE
+#endif
+
+#ifdef CONFIG_HEAP_USE_TLSF
+/*---------- macro ----------*/
+/* heap protect callback defition */
+#ifndef CONFIG_HEAP_LOCK
+#define CONFIG_HEAP_LOCK()
+#endif
+
+#ifndef CONFIG_HEAP_UNLOCK
+#define CONFIG_HEAP_UNLOCK()
+#endif
+
+/* heap port macro defition */
+#ifndef CONFIG_HEAP_BYTE_ALIGNMENT
+#define CONFIG_HEAP_BYTE_ALIGNMENT      (8)
+#endif
+
+#if ((CONFIG_HEAP_BYTE_ALIGNMENT - 1) & CONFIG_HEAP_BYTE_ALIGNMENT) || (CONFIG_HEAP_BYTE_ALIGNMENT > 32)
+#error "CONFIG_HEAP_BYTE_ALIGNMENT must be one of the following values: 1, 2, 4, 8, 16 or 32"
+#endif
+
+#ifndef CONFIG_HEAP_TOTAL_SIZE
+#error "Please define the head total size before use this heap program"
+#endif
+
+/* log2 of the second level list count, every power of two range is split
+ * into (1 << CONFIG_HEAP_TLSF_SL_INDEX_SHIFT) linear size classes. */
+#ifndef CONFIG_HEAP_TLSF_SL_INDEX_SHIFT
+#define CONFIG_HEAP_TLSF_SL_INDEX_SHIFT (4)
+#endif
+
+/* log2 of the largest block managed by the engine, bigger memory is split
+ * into several blocks at initialization. */
+#ifndef CONFIG_HEAP_TLSF_FL_INDEX_MAX
+#define CONFIG_HEAP_TLSF_FL_INDEX_MAX   (20)
+#endif
+
+#ifndef CONFIG_HEAP_REGION_MAX
+#define CONFIG_HEAP_REGION_MAX          (3)
+#endif
+
+#if (CONFIG_HEAP_REGION_MAX < 1) || (CONFIG_HEAP_REGION_MAX > 32)
+#error "CONFIG_HEAP_REGION_MAX must be in range 1 to 32"
+#endif
+
+#if (CONFIG_HEAP_TLSF_SL_INDEX_SHIFT < 1) || (CONFIG_HEAP_TLSF_SL_INDEX_SHIFT > 5)
+#error "CONFIG_HEAP_TLSF_SL_INDEX_SHIFT must be in range 1 to 5"
+#endif
+
+#if (CONFIG_HEAP_TLSF_FL_INDEX_MAX > 31)
+#error "CONFIG_HEAP_TLSF_FL_INDEX_MAX must be less than 32"
+#endif
+
+/* The two low bits of the block size are used as flags, so the engine
+ * granule is at least 4 bytes. */
+#define HEAP_ALIGNMENT                  ((CONFIG_HEAP_BYTE_ALIGNMENT < 4) ? 4 : CONFIG_HEAP_BYTE_ALIGNMENT)
+#define HEAP_ALIGNMENT_MASK             (HEAP_ALIGNMENT - 1)
+#define HEAP_ALIGNMENT_SHIFT            ((HEAP_ALIGNMENT == 32) ? 5 : \
+                                         (HEAP_ALIGNMENT == 16) ? 4 : \
+                                         (HEAP_ALIGNMENT == 8) ? 3 : 2)
+#define HEAP_ALIGN_UP(x)                (((size_t)(x) + HEAP_ALIGNMENT_MASK) & ~((size_t)HEAP_ALIGNMENT_MASK))
+
+/* Sizes below HEAP_SMALL_BLOCK_SIZE are all managed by the first level list 0
+ * and are split linearly into second level lists. */
+#define HEAP_SL_INDEX_COUNT             (1U << CONFIG_HEAP_TLSF_SL_INDEX_SHIFT)
+#define HEAP_FL_INDEX_SHIFT             (CONFIG_HEAP_TLSF_SL_INDEX_SHIFT + HEAP_ALIGNMENT_SHIFT)
+#define HEAP_FL_INDEX_COUNT             (CONFIG_HEAP_TLSF_FL_INDEX_MAX - HEAP_FL_INDEX_SHIFT + 1)
+#define HEAP_SMALL_BLOCK_SIZE           ((size_t)1 << HEAP_FL_INDEX_SHIFT)
+#define HEAP_BLOCK_SIZE_MAX             ((size_t)1 << CONFIG_HEAP_TLSF_FL_INDEX_MAX)
+
+#if (CONFIG_HEAP_TLSF_FL_INDEX_MAX <= (CONFIG_HEAP_TLSF_SL_INDEX_SHIFT + 5))
+#error "CONFIG_HEAP_TLSF_FL_INDEX_MAX is too small"
+#endif
+
+/* block size flags */
+#define HEAP_BLOCK_FREE_BIT             ((size_t)1)
+/* Set in an allocated block aligned by heap_malloc_aligned(), the thread cache does not take it. */
+#define HEAP_BLOCK_ALIGNED_BIT          ((size_t)2)
+#define HEAP_BLOCK_FLAGS_MASK           ((size_t)3)
+
+/* Block sizes must not get too small. */
+#define HEAP_MINIMUM_BLOCK_SIZE         (HEAP_ALIGN_UP(sizeof(block_header_t)))
+
+/* The return address of the public API is recorded by the heap tracer. */
+#if defined(__GNUC__)
+#define HEAP_CALLER()                   __builtin_return_address(0)
+#else
+#define HEAP_CALLER()                   NULL
+#endif
+
+/*---------- type define ----------*/
+/* Every block begins with the physical link and the size, the free list links
+ * overlay the payload, so they only cost memory while the block is free. */
+typedef struct a_block_header {
+    struct a_block_header *pprev_phys_block;    /*<< The previous block in memory. */
+    size_t block_size;                          /*<< The size of block, include the header. */
+    struct a_block_header *pnext_free_block;    /*<< The next free block in the same list. */
+    struct a_block_header *pprev_free_block;    /*<< The previous free block in the same list. */
+} block_header_t;
+
+/* Every region owns its bitmaps and lists, so that an allocation can be
+ * restricted to some regions without losing the constant time search. */
+typedef struct a_heap_region {
+    uint32_t fl_bitmap;                                                 /*<< Bit i is set when a list of first level i is not empty. */
+    uint32_t sl_bitmap[HEAP_FL_INDEX_COUNT];                            /*<< Bit j of sl_bitmap[i] is set when list [i][j] is not empty. */
+    block_header_t *free_blocks[HEAP_FL_INDEX_COUNT][HEAP_SL_INDEX_COUNT];  /*<< Heads of the segregated free lists. */
+    uint8_t *pbase;                                                     /*<< The first block of the region. */
+    block_header_t *pend;                                               /*<< Zero size block which is always used, marks the end. */
+    size_t free_bytes_remaining;
+    size_t minimum_free_bytes_remaining;
+} heap_region_t;
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+/* Allocate the memory for the heap. */
+static uint8_t heap[CONFIG_HEAP_TOTAL_SIZE];
+/* The size of the structure placed at the beginning of each allocated memory
+ * block must by correctly byte aligned. */
+static const size_t heap_struct_size = HEAP_ALIGN_UP(offsetof(block_header_t, pnext_free_block));
+/* Region 0 is the heap array above, others are added by heap_add_region(). */
+static heap_region_t regions[CONFIG_HEAP_REGION_MAX];
+static uint32_t region_count = 0;
+/* Keeps track of the number of free bytes remaining, but says nothing about
+ * fragmentation. */
+static size_t free_bytes_remaining = 0U;
+static size_t minimum_free_bytes_remaining = 0U;
+
+/*---------- function ----------*/
+static inline int heap_fls(size_t word)
+{
+    int bit = -1;
+
+    if(word) {
+#if defined(__GNUC__)
+        bit = (int)(sizeof(unsigned long) * 8) - 1 - __builtin_clzl((unsigned long)word);
+#elif defined(__CC_ARM)
+        bit = 31 - (int)__clz((uint32_t)word);
+#else
+        for(bit = 0; word >>= 1; ++bit) {
+        }
+#endif
+    }
+
+    return bit;
+}
+
+static inline int heap_ffs(uint32_t word)
+{
+    int bit = -1;
+
+    if(word) {
+        bit = heap_fls(word & (~word + 1));
+    }
+
+    return bit;
+}
+
+static inline size_t heap_block_size(const block_header_t *pblock)
+{
+    return pblock->block_size & ~HEAP_BLOCK_FLAGS_MASK;
+}
+
+static inline bool heap_block_is_free(const block_header_t *pblock)
+{
+    return (0 != (pblock->block_size & HEAP_BLOCK_FREE_BIT));
+}
+
+static inline block_header_t *heap_block_next(const block_header_t *pblock)
+{
+    return (block_header_t *)((uint8_t *)pblock + heap_block_size(pblock));
+}
+
+static void heap_mapping_insert(size_t size, int *pfl, int *psl)
+{
+    int fl = 0, sl = 0;
+
+    if(size < HEAP_SMALL_BLOCK_SIZE) {
+        fl = 0;
+        sl = (int)(size / (HEAP_SMALL_BLOCK_SIZE / HEAP_SL_INDEX_COUNT));
+    } else {
+        fl = heap_fls(size);
+        sl = (int)(size >> (fl - CONFIG_HEAP_TLSF_SL_INDEX_SHIFT)) ^ (int)HEAP_SL_INDEX_COUNT;
+        fl -= (HEAP_FL_INDEX_SHIFT - 1);
+    }
+    *pfl = fl;
+    *psl = sl;
+}
+
+static void heap_mapping_search(size_t size, int *pfl, int *psl)
+{
+    /* Round up to the next list so that every block of the found list
+     * can hold the requested size. */
+    if(size >= HEAP_SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (heap_fls(size) - CONFIG_HEAP_TLSF_SL_INDEX_SHIFT)) - 1;
+    }
+    heap_mapping_insert(size, pfl, psl);
+}
+
+static block_header_t *heap_search_suitable_block(heap_region_t *pregion, int *pfl, int *psl)
+{
+    int fl = *pfl, sl = *psl;
+    uint32_t sl_map = 0, fl_map = 0;
+    block_header_t *pblock = NULL;
+
+    if(fl < HEAP_FL_INDEX_COUNT) {
+        sl_map = pregion->sl_bitmap[fl] & (~(uint32_t)0 << sl);
+        if(!sl_map) {
+            fl_map = pregion->fl_bitmap & (~(uint32_t)0 << (fl + 1));
+            if(fl_map) {
+                fl = heap_ffs(fl_map);
+                sl_map = pregion->sl_bitmap[fl];
+            }
+        }
+        if(sl_map) {
+            sl = heap_ffs(sl_map);
+            pblock = pregion->free_blocks[fl][sl];
+            *pfl = fl;
+            *psl = sl;
+        }
+    }
+
+    return pblock;
+}
+
+static void heap_remove_free_block(heap_region_t *pregion, block_header_t *pblock, int fl, int sl)
+{
+    block_header_t *pprev = pblock->pprev_free_block;
+    block_header_t *pnext = pblock->pnext_free_block;
+
+    if(pnext) {
+        pnext->pprev_free_block = pprev;
+    }
+    if(pprev) {
+        pprev->pnext_free_block = pnext;
+    } else {
+        pregion->free_blocks[fl][sl] = pnext;
+        if(NULL == pnext) {
+            pregion->sl_bitmap[fl] &= ~((uint32_t)1 << sl);
+            if(0 == pregion->sl_bitmap[fl]) {
+                pregion->fl_bitmap &= ~((uint32_t)1 << fl);
+            }
+        }
+    }
+}
+
+static void heap_insert_free_block(heap_region_t *pregion, block_header_t *pblock, int fl, int sl)
+{
+    block_header_t *pcurrent = pregion->free_blocks[fl][sl];
+
+    pblock->pnext_free_block = pcurrent;
+    pblock->pprev_free_block = NULL;
+    if(pcurrent) {
+        pcurrent->pprev_free_block = pblock;
+    }
+    pregion->free_blocks[fl][sl] = pblock;
+    pregion->fl_bitmap |= ((uint32_t)1 << fl);
+    pregion->sl_bitmap[fl] |= ((uint32_t)1 << sl);
+}
+
+static void heap_remove_block(heap_region_t *pregion, block_header_t *pblock)
+{
+    int fl = 0, sl = 0;
+
+    heap_mapping_insert(heap_block_size(pblock), &fl, &sl);
+    heap_remove_free_block(pregion, pblock, fl, sl);
+}
+
+static void heap_insert_block(heap_region_t *pregion, block_header_t *pblock)
+{
+    int fl = 0, sl = 0;
+
+    heap_mapping_insert(heap_block_size(pblock), &fl, &sl);
+    heap_insert_free_block(pregion, pblock, fl, sl);
+}
+
+static block_header_t *heap_merge_block(heap_region_t *pregion, block_header_t *pblock)
+{
+    block_header_t *pneighbour = NULL;
+    size_t size = heap_block_size(pblock);
+
+    /* The boundary tag gives the previous physical block in O(1). */
+    pneighbour = pblock->pprev_phys_block;
+    if(pneighbour && heap_block_is_free(pneighbour) &&
+       (heap_block_size(pneighbour) + size) < HEAP_BLOCK_SIZE_MAX) {
+        heap_remove_block(pregion, pneighbour);
+        size += heap_block_size(pneighbour);
+        pblock = pneighbour;
+    }
+    pneighbour = (block_header_t *)((uint8_t *)pblock + size);
+    if(heap_block_is_free(pneighbour) &&
+       (heap_block_size(pneighbour) + size) < HEAP_BLOCK_SIZE_MAX) {
+        heap_remove_block(pregion, pneighbour);
+        size += heap_block_size(pneighbour);
+    }
+    pblock->block_size = size | HEAP_BLOCK_FREE_BIT;
+    heap_block_next(pblock)->pprev_phys_block = pblock;
+
+    return pblock;
+}
+
+static bool heap_region_init(heap_region_t *pregion, void *pstart, size_t total_heap_size)
+{
+    block_header_t *pblock = NULL, *pprev = NULL;
+    size_t address = 0, end_address = 0, size = 0;
+    bool retval = false;
+
+    address = HEAP_ALIGN_UP(pstart);
+    end_address = ((size_t)pstart) + total_heap_size;
+    /* pend is used to mark the end of the heap space. */
+    if(end_address > address && (end_address - address) >= (heap_struct_size + HEAP_MINIMUM_BLOCK_SIZE + HEAP_ALIGNMENT)) {
+        end_address -= heap_struct_size;
+        end_address &= ~((size_t)HEAP_ALIGNMENT_MASK);
+        memset(pregion, 0, sizeof(*pregion));
+        pregion->pbase = (uint8_t *)address;
+        /* The heap space is split into blocks which are not bigger than the
+         * largest size class. */
+        while((end_address - address) >= HEAP_MINIMUM_BLOCK_SIZE) {
+            size = end_address - address;
+            if(size >= HEAP_BLOCK_SIZE_MAX) {
+                size = HEAP_BLOCK_SIZE_MAX - HEAP_ALIGNMENT;
+            }
+            pblock = (void *)address;
+            pblock->pprev_phys_block = pprev;
+            pblock->block_size = size | HEAP_BLOCK_FREE_BIT;
+            heap_insert_block(pregion, pblock);
+            pregion->free_bytes_remaining += size;
+            pprev = pblock;
+            address += size;
+        }
+        pregion->pend = (void *)address;
+        pregion->pend->pprev_phys_block = pprev;
+        pregion->pend->block_size = 0;
+        pregion->minimum_free_bytes_remaining = pregion->free_bytes_remaining;
+        free_bytes_remaining += pregion->free_bytes_remaining;
+        minimum_free_bytes_remaining += pregion->free_bytes_remaining;
+        retval = true;
+    }
+
+    return retval;
+}
+
+static void heap_init(void)
+{
+    if(heap_region_init(&regions[0], heap, CONFIG_HEAP_TOTAL_SIZE)) {
+        region_count = 1;
+    }
+}
+
+static heap_region_t *heap_find_region(const void *p)
+{
+    heap_region_t *pregion = NULL;
+
+    for(uint32_t i = 0; i < region_count; ++i) {
+        if((const uint8_t *)p >= regions[i].pbase && (const uint8_t *)p < (const uint8_t *)regions[i].pend) {
+            pregion = &regions[i];
+            break;
+        }
+    }
+
+    return pregion;
+}
+
+static size_t heap_block_align_offset(block_header_t *pblock, size_t alignment)
+{
+    size_t address = (size_t)pblock + heap_struct_size;
+    size_t offset = ((address + alignment - 1) & ~(alignment - 1)) - address;
+
+    /* The padding in front of the aligned block is returned to the free list,
+     * so it must be big enough to be a block itself. */
+    while((0 != offset) && (offset < HEAP_MINIMUM_BLOCK_SIZE)) {
+        offset += alignment;
+    }
+
+    return offset;
+}
+
+static void *heap_region_malloc(heap_region_t *pregion, size_t wanted_size, size_t alignment)
+{
+    block_header_t *pblock = NULL, *pblock_new = NULL;
+    void *preturn = NULL;
+    size_t search_size = wanted_size, offset = 0;
+    int fl = 0, sl = 0;
+
+    /* Reserve room for the worst alignment padding, the padding is trimmed
+     * back to the free list once the block was found. */
+    if(0 != alignment) {
+        search_size += alignment + HEAP_MINIMUM_BLOCK_SIZE;
+    }
+    if(search_size <= pregion->free_bytes_remaining && search_size < HEAP_BLOCK_SIZE_MAX) {
+        heap_mapping_search(search_size, &fl, &sl);
+        pblock = heap_search_suitable_block(pregion, &fl, &sl);
+    }
+    if(pblock) {
+        heap_remove_free_block(pregion, pblock, fl, sl);
+        offset = (0 != alignment) ? heap_block_align_offset(pblock, alignment) : 0;
+        if(0 != offset) {
+            pblock_new = (void *)(((uint8_t *)pblock) + offset);
+            pblock_new->pprev_phys_block = pblock;
+            pblock_new->block_size = (heap_block_size(pblock) - offset) | HEAP_BLOCK_FREE_BIT;
+            heap_block_next(pblock_new)->pprev_phys_block = pblock_new;
+            pblock->block_size = offset | HEAP_BLOCK_FREE_BIT;
+            heap_insert_block(pregion, pblock);
+            pblock = pblock_new;
+        }
+        /* If the block is larger than required it can be split into
+         * two. */
+        if((heap_block_size(pblock) - wanted_size) >= HEAP_MINIMUM_BLOCK_SIZE) {
+            pblock_new = (void *)(((uint8_t *)pblock) + wanted_size);
+            pblock_new->pprev_phys_block = pblock;
+            pblock_new->block_size = (heap_block_size(pblock) - wanted_size) | HEAP_BLOCK_FREE_BIT;
+            heap_block_next(pblock_new)->pprev_phys_block = pblock_new;
+            heap_insert_block(pregion, pblock_new);
+            pblock->block_size = wanted_size;
+        }
+        pblock->block_size &= ~HEAP_BLOCK_FREE_BIT;
+        if(0 != alignment) {
+            pblock->block_size |= HEAP_BLOCK_ALIGNED_BIT;
+        }
+        pregion->free_bytes_remaining -= heap_block_size(pblock);
+        if(pregion->minimum_free_bytes_remaining > pregion->free_bytes_remaining) {
+            pregion->minimum_free_bytes_remaining = pregion->free_bytes_remaining;
+        }
+        free_bytes_remaining -= heap_block_size(pblock);
+        if(minimum_free_bytes_remaining > free_bytes_remaining) {
+            minimum_free_bytes_remaining = free_bytes_remaining;
+        }
+        preturn = (void *)(((uint8_t *)pblock) + heap_struct_size);
+    }
+
+    return preturn;
+}
+
+int32_t heap_add_region(void *pstart, size_t size)
+{
+    int32_t region = -1;
+
+    CONFIG_HEAP_LOCK();
+    {
+        if(0 == region_count) {
+            heap_init();
+        }
+        if(NULL != pstart && region_count < CONFIG_HEAP_REGION_MAX &&
+           heap_region_init(&regions[region_count], pstart, size)) {
+            region = (int32_t)region_count;
+            region_count++;
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+
+    return region;
+}
+
+static bool heap_region_resize(heap_region_t *pregion, block_header_t *pblock, size_t wanted_size)
+{
+    block_header_t *pblock_next = heap_block_next(pblock), *pblock_new = NULL;
+    size_t block_size = heap_block_size(pblock);
+    size_t aligned = pblock->block_size & HEAP_BLOCK_ALIGNED_BIT;
+    bool retval = true;
+
+    if(wanted_size > block_size) {
+        /* Grow into the following block if it is free. */
+        retval = false;
+        if(heap_block_is_free(pblock_next) &&
+           ((block_size + heap_block_size(pblock_next)) >= wanted_size) &&
+           ((block_size + heap_block_size(pblock_next)) < HEAP_BLOCK_SIZE_MAX)) {
+            heap_remove_block(pregion, pblock_next);
+            pregion->free_bytes_remaining -= heap_block_size(pblock_next);
+            free_bytes_remaining -= heap_block_size(pblock_next);
+            block_size += heap_block_size(pblock_next);
+            pblock->block_size = block_size | aligned;
+            heap_block_next(pblock)->pprev_phys_block = pblock;
+            retval = true;
+        }
+    }
+    if(retval) {
+        /* Give the unused tail back to the free lists. */
+        if((block_size - wanted_size) >= HEAP_MINIMUM_BLOCK_SIZE) {
+            pblock_new = (void *)(((uint8_t *)pblock) + wanted_size);
+            pblock_new->pprev_phys_block = pblock;
+            pblock_new->block_size = (block_size - wanted_size) | HEAP_BLOCK_FREE_BIT;
+            heap_block_next(pblock_new)->pprev_phys_block = pblock_new;
+            pblock->block_size = wanted_size | aligned;
+            pregion->free_bytes_remaining += heap_block_size(pblock_new);
+            free_bytes_remaining += heap_block_size(pblock_new);
+            pblock_new = heap_merge_block(pregion, pblock_new);
+            heap_insert_block(pregion, pblock_new);
+        }
+        if(pregion->minimum_free_bytes_remaining > pregion->free_bytes_remaining) {
+            pregion->minimum_free_bytes_remaining = pregion->free_bytes_remaining;
+        }
+        if(minimum_free_bytes_remaining > free_bytes_remaining) {
+            minimum_free_bytes_remaining = free_bytes_remaining;
+        }
+    }
+
+    return retval;
+}
+
+/* Must be called with the heap locked. */
+static void *heap_malloc_locked(uint32_t region_mask, size_t wanted_size, size_t alignment)
+{
+    void *preturn = NULL;
+
+    if(0 == region_count) {
+        heap_init();
+    }
+    /* Check the requested block size is not so large that the header can
+     * not be added. */
+    if((0 < wanted_size) && (wanted_size < (HEAP_BLOCK_SIZE_MAX - heap_struct_size))) {
+        wanted_size = HEAP_ALIGN_UP(wanted_size + heap_struct_size);
+        if(wanted_size < HEAP_MINIMUM_BLOCK_SIZE) {
+            wanted_size = HEAP_MINIMUM_BLOCK_SIZE;
+        }
+        /* Regions are tried in the order they were added. */
+        for(uint32_t i = 0; i < region_count && NULL == preturn; ++i) {
+            if(region_mask & HEAP_REGION_MASK(i)) {
+                preturn = heap_region_malloc(&regions[i], wanted_size, alignment);
+            }
+        }
+    }
+
+    return preturn;
+}
+
+static void *heap_malloc_common(uint32_t region_mask, size_t wanted_size, size_t alignment, void *caller)
+{
+    void *preturn = NULL;
+
+    CONFIG_HEAP_LOCK();
+    preturn = heap_malloc_locked(region_mask, wanted_size, alignment);
+    heap_stats_record((NULL != preturn) ? HEAP_TRACE_MALLOC : HEAP_TRACE_FAILED, caller, preturn, wanted_size);
+    CONFIG_HEAP_UNLOCK();
+
+    return preturn;
+}
+
+static void *heap_malloc_aligned_common(uint32_t region_mask, size_t wanted_size, size_t alignment, void *caller)
+{
+    void *preturn = NULL;
+
+    /* The alignment must be a power of two. */
+    if((0 != alignment) && (0 == (alignment & (alignment - 1))) && (alignment < HEAP_BLOCK_SIZE_MAX)) {
+        if(alignment <= HEAP_ALIGNMENT) {
+            alignment = 0;
+        }
+        preturn = heap_malloc_common(region_mask, wanted_size, alignment, caller);
+    }
+
+    return preturn;
+}
+
+void *heap_malloc_in(uint32_t region_mask, size_t wanted_size)
+{
+    return heap_malloc_common(region_mask, wanted_size, 0, HEAP_CALLER());
+}
+
+void *heap_malloc(size_t wanted_size)
+{
+    void *preturn = NULL;
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+    preturn = heap_thread_cache_malloc(wanted_size, HEAP_CALLER());
+#endif
+    if(NULL == preturn) {
+        preturn = heap_malloc_common(HEAP_REGION_ANY, wanted_size, 0, HEAP_CALLER());
+    }
+
+    return preturn;
+}
+
+uint32_t heap_malloc_batch(size_t wanted_size, void **pptrs, uint32_t count)
+{
+    uint32_t allocated = 0;
+
+    CONFIG_HEAP_LOCK();
+    for(; allocated < count; ++allocated) {
+        pptrs[allocated] = heap_malloc_locked(HEAP_REGION_MASK(0), wanted_size, 0);
+        if(NULL == pptrs[allocated]) {
+            break;
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+
+    return allocated;
+}
+
+void *heap_malloc_aligned_in(uint32_t region_mask, size_t wanted_size, size_t alignment)
+{
+    return heap_malloc_aligned_common(region_mask, wanted_size, alignment, HEAP_CALLER());
+}
+
+void *heap_malloc_aligned(size_t wanted_size, size_t alignment)
+{
+    return heap_malloc_aligned_common(HEAP_REGION_ANY, wanted_size, alignment, HEAP_CALLER());
+}
+
+/* Must be called with the heap locked. The payload size of the freed block is
+ * returned, 0 if the block does not belong to the application. */
+static size_t heap_free_locked(void *pfree)
+{
+    block_header_t *pblock = (void *)(((uint8_t *)pfree) - heap_struct_size);
+    heap_region_t *pregion = NULL;
+    size_t size = 0;
+
+    pregion = heap_find_region(pblock);
+    /* Only the blocks belong to the application can be returned. */
+    if(pregion && !heap_block_is_free(pblock) && 0 != heap_block_size(pblock)) {
+        size = heap_block_size(pblock) - heap_struct_size;
+        pregion->free_bytes_remaining += heap_block_size(pblock);
+        free_bytes_remaining += heap_block_size(pblock);
+        pblock = heap_merge_block(pregion, pblock);
+        heap_insert_block(pregion, pblock);
+    }
+
+    return size;
+}
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+/* The magazines are refilled from the built-in heap without alignment, so a block of
+ * another region or an aligned one is returned to its region at once. */
+static bool heap_block_is_cacheable(void *ptr)
+{
+    block_header_t *pblock = (void *)(((uint8_t *)ptr) - heap_struct_size);
+
+    return (NULL != ptr && (uint8_t *)pblock >= heap && (uint8_t *)pblock < &heap[CONFIG_HEAP_TOTAL_SIZE] &&
+            !heap_block_is_free(pblock) && 0 != heap_block_size(pblock) &&
+            0 == (pblock->block_size & HEAP_BLOCK_ALIGNED_BIT));
+}
+#endif
+
+static void heap_free_common(void *pfree, void *caller)
+{
+    size_t size = 0;
+
+    if(NULL != pfree) {
+        CONFIG_HEAP_LOCK();
+        size = heap_free_locked(pfree);
+        if(0 != size) {
+            heap_stats_record(HEAP_TRACE_FREE, caller, pfree, size);
+        }
+        CONFIG_HEAP_UNLOCK();
+    }
+}
+
+void heap_free(void *pfree)
+{
+    bool cached = false;
+
+#ifdef CONFIG_HEAP_THREAD_CACHE
+    cached = heap_block_is_cacheable(pfree) && heap_thread_cache_free(pfree, HEAP_CALLER());
+#endif
+    if(!cached) {
+        heap_free_common(pfree, HEAP_CALLER());
+    }
+}
+
+void heap_free_batch(void **pptrs, uint32_t count)
+{
+    CONFIG_HEAP_LOCK();
+    for(uint32_t i = 0; i < count; ++i) {
+        if(NULL != pptrs[i]) {
+            (void)heap_free_locked(pptrs[i]);
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+}
+
+size_t heap_usable_size(void *ptr)
+{
+    block_header_t *pblock = NULL;
+    size_t size = 0;
+
+    if(NULL != ptr) {
+        pblock = (void *)(((uint8_t *)ptr) - heap_struct_size);
+        if(!heap_block_is_free(pblock) && 0 != heap_block_size(pblock)) {
+            size = heap_block_size(pblock) - heap_struct_size;
+        }
+    }
+
+    return size;
+}
+
+void *heap_realloc(void *pold, size_t wanted_size)
+{
+    void *caller = HEAP_CALLER();
+    block_header_t *pblock = NULL;
+    heap_region_t *pregion = NULL;
+    void *preturn = NULL;
+    size_t block_size = 0, copy_size = 0;
+
+    if(NULL == pold) {
+        preturn = heap_malloc_common(HEAP_REGION_ANY, wanted_size, 0, caller);
+    } else if(0 == wanted_size) {
+        heap_free_common(pold, caller);
+    } else if(wanted_size < (HEAP_BLOCK_SIZE_MAX - heap_struct_size)) {
+        pblock = (void *)(((uint8_t *)pold) - heap_struct_size);
+        block_size = HEAP_ALIGN_UP(wanted_size + heap_struct_size);
+        if(block_size < HEAP_MINIMUM_BLOCK_SIZE) {
+            block_size = HEAP_MINIMUM_BLOCK_SIZE;
+        }
+        CONFIG_HEAP_LOCK();
+        {
+            pregion = heap_find_region(pblock);
+            if(NULL != pregion && (heap_block_is_free(pblock) || 0 == heap_block_size(pblock))) {
+                pregion = NULL;
+            }
+            if(NULL != pregion) {
+                copy_size = heap_block_size(pblock) - heap_struct_size;
+                if(heap_region_resize(pregion, pblock, block_size)) {
+                    heap_stats_record(HEAP_TRACE_REALLOC, caller, pold, wanted_size);
+                    preturn = pold;
+                }
+            }
+        }
+        CONFIG_HEAP_UNLOCK();
+        /* The data is moved only when the block can not be resized in place. */
+        if(NULL == preturn && NULL != pregion) {
+            preturn = heap_malloc_common(HEAP_REGION_ANY, wanted_size, 0, caller);
+            if(NULL != preturn) {
+                memcpy(preturn, pold, (copy_size < wanted_size) ? copy_size : wanted_size);
+                heap_free_common(pold, caller);
+            }
+        }
+    }
+
+    return preturn;
+}
+
+void heap_walk(uint32_t region_mask, heap_walker_t walker, void *user_data)
+{
+    block_header_t *pblock = NULL;
+
+    CONFIG_HEAP_LOCK();
+    {
+        if(0 == region_count) {
+            heap_init();
+        }
+        for(uint32_t i = 0; i < region_count && NULL != walker; ++i) {
+            if(0 == (region_mask & HEAP_REGION_MASK(i))) {
+                continue;
+            }
+            for(pblock = (void *)regions[i].pbase; pblock != regions[i].pend; pblock = heap_block_next(pblock)) {
+                walker(((uint8_t *)pblock) + heap_struct_size, heap_block_size(pblock) - heap_struct_size,
+                       !heap_block_is_free(pblock), user_data);
+            }
+        }
+    }
+    CONFIG_HEAP_UNLOCK();
+}
+
+size_t heap_get_free_remaining_size(void)
+{
+    return free_bytes_remaining;
+}
+
+size_t heap_get_minimum_free_remaining_size(void)
+{
+    return minimum_free_bytes_remaining;
+}
+
+size_t heap_get_region_free_remaining_size(uint32_t region)
+{
+    return (region < region_count) ? regions[region].free_bytes_remaining : 0;
+}
+
+size_t heap_get_region_minimum_free_remaining_size(uint32_t region)
+{
+    return (region < region_count) ? regions[region].minimum_free_bytes_remaining : 0;
+}
+#endif
@@ -28,12 +28,221 @@
 #include <stddef.h>
 
 /*---------- macro ----------*/
+/* Region 0 is the built-in heap array, the following regions are numbered
+ * in the order they were added by heap_add_region(). */
+#define HEAP_REGION_MASK(region)        (((uint32_t)1) << (region))
+#define HEAP_REGION_ANY                 (0xFFFFFFFFUL)
+
+/* Bin i of the histogram counts the free blocks whose payload is in range
+ * [16 << i, 32 << i), smaller blocks fall into bin 0 and larger into the last bin. */
+#define HEAP_STATS_HISTOGRAM_SIZE       (16)
+
 /*---------- type define ----------*/
+typedef struct heap_stats *heap_stats_t;
+struct heap_stats {
+    size_t free_bytes;                                  /*<< Sum of the free payload */
+    size_t largest_free_block;                          /*<< Payload of the largest free block */
+    uint32_t free_block_count;                          /*<< Number of free blocks */
+    uint32_t used_block_count;                          /*<< Number of allocated blocks */
+    uint32_t fragmentation;                             /*<< 0 - 100, (free_bytes - largest_free_block) * 100 / free_bytes */
+    uint32_t histogram[HEAP_STATS_HISTOGRAM_SIZE];      /*<< Size classes of the free blocks */
+    uint32_t alloc_count;                               /*<< Number of successful allocations */
+    uint32_t free_count;                                /*<< Number of frees */
+    uint32_t failed_count;                              /*<< Number of failed allocations */
+};
+
+typedef enum {
+    HEAP_TRACE_MALLOC,
+    HEAP_TRACE_FREE,
+    HEAP_TRACE_REALLOC,
+    HEAP_TRACE_FAILED
+} heap_trace_op_t;
+
+typedef struct heap_trace_record *heap_trace_record_t;
+struct heap_trace_record {
+    void *caller;                                       /*<< Return address of the heap API */
+    void *ptr;                                          /*<< The block, NULL for HEAP_TRACE_FAILED */
+    uint32_t size;                                      /*<< Requested size, or the payload for HEAP_TRACE_FREE */
+    uint32_t timestamp;                                 /*<< CONFIG_HEAP_TRACE_TIMESTAMP() */
+    uint8_t op;                                         /*<< heap_trace_op_t */
+};
+
+/**
+ * @brief The callback of heap_walk().
+ * @param ptr The payload of the block.
+ * @param size The payload size of the block.
+ * @param used True if the block belongs to the application.
+ * @param user_data The user_data passed to heap_walk().
+ */
+typedef void (*heap_walker_t)(void *ptr, size_t size, bool used, void *user_data);
+
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 extern void *heap_malloc(size_t wanted_size);
 extern void heap_free(void *pfree);
+
+/**
+ * @brief Change the size of a block allocated by the heap. The block grows in place
+ * when the following block is free and shrinks in place by returning its tail to the
+ * free list. The data is only moved to a new block when it can not be resized in place,
+ * the new block does not keep the alignment of heap_malloc_aligned().
+ * @param pold The block to resize. If it is NULL, heap_realloc() is equivalent to heap_malloc().
+ * @param wanted_size The new size. If it is 0, the block is freed and NULL is returned.
+ *
+ * @retval A pointer to the resized block, it may be different from pold. If the block can
+ * not be resized then NULL is returned and pold is left unchanged.
+ */
+extern void *heap_realloc(void *pold, size_t wanted_size);
+
+/**
+ * @brief Allocate count blocks of the same size from the built-in heap with the heap
+ * locked only once. The blocks fill a cache, so they are not recorded by the statistics
+ * and the tracer, the cache records the blocks it hands out.
+ * @param wanted_size The size of every block.
+ * @param pptrs The container for storing the blocks.
+ * @param count The number of blocks wanted.
+ *
+ * @retval The number of blocks allocated, it is less than count if the heap is exhausted.
+ */
+extern uint32_t heap_malloc_batch(size_t wanted_size, void **pptrs, uint32_t count);
+
+/**
+ * @brief Free count blocks with the heap locked only once, NULL entries are skipped.
+ * The blocks are flushed from a cache, so they are not recorded by the statistics.
+ * @param pptrs The blocks being freed.
+ * @param count The number of blocks.
+ *
+ * @retval None
+ */
+extern void heap_free_batch(void **pptrs, uint32_t count);
+
+/**
+ * @brief Query the payload size of an allocated block, it may be larger than the size requested.
+ * @param ptr The block allocated by the heap.
+ *
+ * @retval The payload size or 0 if ptr is NULL or not allocated.
+ */
+extern size_t heap_usable_size(void *ptr);
 extern size_t heap_get_free_remaining_size(void);
 extern size_t heap_get_minimum_free_remaining_size(void);
 
+/**
+ * @brief Add a non-contiguous memory region to the heap, e.g. a tightly-coupled
+ * or a DMA-capable SRAM bank. At most CONFIG_HEAP_REGION_MAX regions can be used,
+ * including the built-in heap array.
+ * @param pstart The start address of the region.
+ * @param size The size of the region in bytes.
+ *
+ * @retval The region number used by HEAP_REGION_MASK() is returned. If the region
+ * is too small or there is no free region slot then -1 is returned.
+ */
+extern int32_t heap_add_region(void *pstart, size_t size);
+
+/**
+ * @brief Allocate memory from the selected regions only, the regions are tried
+ * in ascending order. heap_malloc() is equivalent to heap_malloc_in(HEAP_REGION_ANY, size).
+ * @param region_mask Mask of the regions built by HEAP_REGION_MASK().
+ * @param wanted_size The size of memory.
+ *
+ * @retval A pointer to the memory or NULL if no selected region can serve the request.
+ */
+extern void *heap_malloc_in(uint32_t region_mask, size_t wanted_size);
+
+/**
+ * @brief Allocate memory whose address is a multiple of alignment, e.g. a cache line
+ * or a DMA burst. The padding in front of the aligned block is kept in the free list.
+ * The memory is released by heap_free().
+ * @param wanted_size The size of memory.
+ * @param alignment The alignment in bytes, it must be a power of two.
+ *
+ * @retval A pointer to the aligned memory or NULL if the request can not be served.
+ */
+extern void *heap_malloc_aligned(size_t wanted_size, size_t alignment);
+
+/**
+ * @brief Allocate aligned memory from the selected regions only, e.g. a DMA-capable bank.
+ * @param region_mask Mask of the regions built by HEAP_REGION_MASK().
+ * @param wanted_size The size of memory.
+ * @param alignment The alignment in bytes, it must be a power of two.
+ *
+ * @retval A pointer to the aligned memory or NULL if the request can not be served.
+ */
+extern void *heap_malloc_aligned_in(uint32_t region_mask, size_t wanted_size, size_t alignment);
+
+/**
+ * @brief Query the free bytes of a region.
+ * @param region The region number returned by heap_add_region(), 0 is the built-in heap.
+ *
+ * @retval The free bytes of the region, 0 is returned if the region does not exist.
+ */
+extern size_t heap_get_region_free_remaining_size(uint32_t region);
+
+/**
+ * @brief Query the minimum free bytes of a region since it was added.
+ * @param region The region number returned by heap_add_region(), 0 is the built-in heap.
+ *
+ * @retval The minimum free bytes of the region, 0 is returned if the region does not exist.
+ */
+extern size_t heap_get_region_minimum_free_remaining_size(uint32_t region);
+
+/**
+ * @brief Visit every block, used or free, of the selected regions in address order.
+ * The heap is locked during the walk, so the walker must not call the heap API.
+ * @param region_mask Mask of the regions built by HEAP_REGION_MASK().
+ * @param walker The callback invoked for each block.
+ * @param user_data Passed to the walker unchanged.
+ *
+ * @retval None
+ */
+extern void heap_walk(uint32_t region_mask, heap_walker_t walker, void *user_data);
+
+/**
+ * @brief Collect the fragmentation metrics of the selected regions and the global
+ * alloc/free/failure counters. A failed allocation with a small fragmentation index
+ * means the heap was exhausted, with a large one means it was fragmented.
+ * @param region_mask Mask of the regions built by HEAP_REGION_MASK().
+ * @param stats The container for storing statistics.
+ *
+ * @retval None
+ */
+extern void heap_get_stats(uint32_t region_mask, heap_stats_t stats);
+
+/**
+ * @brief Copy the latest trace records, oldest first. The tracer is enabled by
+ * defining CONFIG_HEAP_TRACE_DEPTH, the ring keeps the last CONFIG_HEAP_TRACE_DEPTH records.
+ * @param records The container for storing records.
+ * @param count The capacity of records.
+ *
+ * @retval The number of records copied, 0 is returned if the tracer is disabled.
+ */
+extern uint32_t heap_trace_read(heap_trace_record_t records, uint32_t count);
+
+/**
+ * @brief The per-thread front end of heap_malloc()/heap_free(), enabled by defining
+ * CONFIG_HEAP_THREAD_CACHE on a POSIX host build. Small requests are served from a
+ * magazine of the calling thread without taking CONFIG_HEAP_LOCK, magazines are
+ * refilled from the built-in heap and flushed in batches. Only unaligned blocks of the
+ * built-in heap are taken back. A request the magazines can not serve returns NULL
+ * and a block they do not take returns false, the engine serves it then.
+ * The cached operations are counted per thread and added to the statistics once per
+ * batch, with CONFIG_HEAP_TRACE_DEPTH every one is traced with the heap locked.
+ */
+extern void *heap_thread_cache_malloc(size_t wanted_size, void *caller);
+extern bool heap_thread_cache_free(void *pfree, void *caller);
+
+/**
+ * @brief Return all blocks cached by the calling thread to the heap and add its cached
+ * operations to the statistics, e.g. before heap_get_stats(). It is also done
+ * automatically when the thread exits.
+ *
+ * @retval None
+ */
+extern void heap_thread_cache_flush(void);
+
+/**
+ * @brief Update the counters and the tracer, only used by the heap engines and the
+ * thread cache with the heap locked.
+ */
+extern void heap_stats_record(heap_trace_op_t op, void *caller, void *ptr, size_t size);
+
 #endif /* __HEAP_H */
@@ -0,0 +1,300 @@
+/**
+ * @file common/hr_timer/hr_timer.c
+ *
+ * Copyright (C) 2024
+ *
+ * hr_timer.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "hr_timer.h"
+#include "options.h"
+#include <string.h>
+
+/*---------- macro ----------*/
+/* The number of timers which can be running at the same time. */
+#ifndef CONFIG_HR_TIMER_MAX_COUNT
+#define CONFIG_HR_TIMER_MAX_COUNT           (16)
+#endif
+
+/* The shortest distance in counter ticks between now and the compare value, so the
+ * counter can not pass the compare value before the channel is written. */
+#ifndef CONFIG_HR_TIMER_MIN_DELTA
+#define CONFIG_HR_TIMER_MIN_DELTA           (2)
+#endif
+
+#define HR_TIMER_US_PER_SECOND              (1000000ULL)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static struct hr_timer_ops _ops;
+static uint64_t _ticks;                     /*<< The counter extended to 64 bits */
+static uint32_t _last_counter;              /*<< The counter value added to _ticks last time */
+static hr_timer_t _heap[CONFIG_HR_TIMER_MAX_COUNT];     /*<< Min-heap ordered by expires */
+static uint32_t _heap_count;
+
+/*---------- function ----------*/
+static inline void _lock(void)
+{
+    __enter_critical();
+}
+
+static inline void _unlock(void)
+{
+    __exit_critical();
+}
+
+/* The counter must be read at least once per wrap, the compare channel is never
+ * armed farther than half of the wrap, so the compare interrupt keeps it going
+ * even if no timer is running. */
+static uint64_t _now_ticks(void)
+{
+    uint32_t counter = _ops.get_counter() & _ops.counter_mask;
+
+    _ticks += (counter - _last_counter) & _ops.counter_mask;
+    _last_counter = counter;
+
+    return _ticks;
+}
+
+/* Round up, a timer never expires before its deadline. */
+static uint64_t _us_to_ticks(uint64_t us)
+{
+    return (us / HR_TIMER_US_PER_SECOND) * _ops.freq +
+           ((us % HR_TIMER_US_PER_SECOND) * _ops.freq + HR_TIMER_US_PER_SECOND - 1) / HR_TIMER_US_PER_SECOND;
+}
+
+static uint64_t _ticks_to_us(uint64_t ticks)
+{
+    return (ticks / _ops.freq) * HR_TIMER_US_PER_SECOND +
+           ((ticks % _ops.freq) * HR_TIMER_US_PER_SECOND) / _ops.freq;
+}
+
+static void _heap_sift_up(uint32_t index)
+{
+    hr_timer_t timer = _heap[index];
+    uint32_t parent = 0;
+
+    while(index) {
+        parent = (index - 1) / 2;
+        if(_heap[parent]->expires <= timer->expires) {
+            break;
+        }
+        _heap[index] = _heap[parent];
+        _heap[index]->index = index;
+        index = parent;
+    }
+    _heap[index] = timer;
+    timer->index = index;
+}
+
+static void _heap_sift_down(uint32_t index)
+{
+    hr_timer_t timer = _heap[index];
+    uint32_t child = 0;
+
+    for(;;) {
+        child = index * 2 + 1;
+        if(child >= _heap_count) {
+            break;
+        }
+        if((child + 1) < _heap_count && _heap[child + 1]->expires < _heap[child]->expires) {
+            child++;
+        }
+        if(timer->expires <= _heap[child]->expires) {
+            break;
+        }
+        _heap[index] = _heap[child];
+        _heap[index]->index = index;
+        index = child;
+    }
+    _heap[index] = timer;
+    timer->index = index;
+}
+
+static void _heap_insert(hr_timer_t timer)
+{
+    _heap[_heap_count] = timer;
+    timer->index = _heap_count;
+    _heap_count++;
+    _heap_sift_up(timer->index);
+}
+
+static void _heap_remove(hr_timer_t timer)
+{
+    uint32_t index = timer->index;
+
+    _heap_count--;
+    timer->index = HR_TIMER_INACTIVE;
+    if(index < _heap_count) {
+        _heap[index] = _heap[_heap_count];
+        _heap[index]->index = index;
+        _heap_sift_up(index);
+        _heap_sift_down(_heap[index]->index);
+    }
+}
+
+/* Arm the compare channel for the first timer in the queue. If the counter has passed
+ * the compare value before it was written, the match is lost, so try it again later. */
+static bool _program(void)
+{
+    uint64_t now = 0, target = 0;
+    bool retval = false;
+
+    do {
+        now = _now_ticks();
+        target = now + (_ops.counter_mask >> 1);
+        if(_heap_count && _heap[0]->expires < target) {
+            target = _heap[0]->expires;
+            if(target < now + CONFIG_HR_TIMER_MIN_DELTA) {
+                target = now + CONFIG_HR_TIMER_MIN_DELTA;
+            }
+        }
+        retval = _ops.set_compare((uint32_t)target & _ops.counter_mask);
+    } while(retval && _now_ticks() >= target);
+
+    return retval;
+}
+
+bool hr_timer_init(const struct hr_timer_ops *ops)
+{
+    bool retval = false;
+
+    assert(ops);
+    assert(ops->freq);
+    assert(ops->counter_mask);
+    assert(ops->get_counter);
+    assert(ops->set_compare);
+    _lock();
+    memcpy(&_ops, ops, sizeof(_ops));
+    _heap_count = 0;
+    _ticks = 0;
+    _last_counter = _ops.get_counter() & _ops.counter_mask;
+    retval = _program();
+    _unlock();
+
+    return retval;
+}
+
+uint64_t hr_timer_now(void)
+{
+    uint64_t ticks = 0;
+
+    _lock();
+    ticks = _now_ticks();
+    _unlock();
+
+    return _ticks_to_us(ticks);
+}
+
+void hr_timer_setup(hr_timer_t timer, hr_timer_cb_t cb, void *user_data)
+{
+    assert(timer);
+    assert(cb);
+    timer->deadline = 0;
+    timer->expires = 0;
+    timer->index = HR_TIMER_INACTIVE;
+    timer->cb = cb;
+    timer->user_data = user_data;
+}
+
+bool hr_timer_start_at(hr_timer_t timer, uint64_t deadline)
+{
+    bool retval = false;
+
+    assert(timer);
+    _lock();
+    do {
+        if(timer->index != HR_TIMER_INACTIVE) {
+            _heap_remove(timer);
+        } else if(_heap_count >= CONFIG_HR_TIMER_MAX_COUNT) {
+            break;
+        }
+        timer->deadline = deadline;
+        timer->expires = _us_to_ticks(deadline);
+        _heap_insert(timer);
+        if(timer->index == 0) {
+            _program();
+        }
+        retval = true;
+    } while(0);
+    _unlock();
+
+    return retval;
+}
+
+bool hr_timer_start(hr_timer_t timer, uint64_t delay)
+{
+    return hr_timer_start_at(timer, hr_timer_now() + delay);
+}
+
+void hr_timer_stop(hr_timer_t timer)
+{
+    assert(timer);
+    _lock();
+    /* The compare channel is left armed, the spare interrupt finds nothing expired. */
+    if(timer->index != HR_TIMER_INACTIVE) {
+        _heap_remove(timer);
+    }
+    _unlock();
+}
+
+bool hr_timer_is_active(hr_timer_t timer)
+{
+    assert(timer);
+
+    return (timer->index != HR_TIMER_INACTIVE);
+}
+
+uint64_t hr_timer_get_deadline(hr_timer_t timer)
+{
+    assert(timer);
+
+    return timer->deadline;
+}
+
+void *hr_timer_get_user_data(hr_timer_t timer)
+{
+    assert(timer);
+
+    return timer->user_data;
+}
+
+void hr_timer_isr(void)
+{
+    hr_timer_t timer = NULL;
+
+    for(;;) {
+        _lock();
+        timer = NULL;
+        if(_heap_count && _heap[0]->expires <= _now_ticks()) {
+            timer = _heap[0];
+            _heap_remove(timer);
+        }
+        if(!timer) {
+            _program();
+            _unlock();
+            break;
+        }
+        _unlock();
+        /* Unlocked, the callback may start or stop any timer including itself. */
+        timer->cb(timer);
+    }
+}
@@ -0,0 +1,159 @@
+/**
+ * @file common/hr_timer/inc/hr_timer.h
+ *
+ * Copyright (C) 2024
+ *
+ * hr_timer.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+#ifndef __HR_TIMER_H
+#define __HR_TIMER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*---------- macro ----------*/
+/* The index of a timer which is not in the queue. */
+#define HR_TIMER_INACTIVE                   (0xFFFFFFFFUL)
+
+/*---------- type define ----------*/
+typedef struct hr_timer *hr_timer_t;
+
+typedef void (*hr_timer_cb_t)(hr_timer_t timer);
+
+/* The timer is owned by the caller, it must stay valid while it is in the queue. */
+struct hr_timer {
+    uint64_t deadline;          /*<< The deadline in microseconds */
+    uint64_t expires;           /*<< The deadline in counter ticks */
+    uint32_t index;             /*<< The position in the queue, HR_TIMER_INACTIVE if stopped */
+    hr_timer_cb_t cb;
+    void *user_data;
+};
+
+/* The compare channel of a hardware timer, e.g. the ops of a drv/timer.c bsp or the
+ * IOCTL_TIMER_GET_COUNTER and IOCTL_TIMER_SET_COMPARE commands wrapped by the board.
+ * The compare interrupt must call hr_timer_isr().
+ */
+struct hr_timer_ops {
+    uint32_t freq;              /*<< The counter frequency in Hz */
+    uint32_t counter_mask;      /*<< 0xFFFF for a 16-bit counter, 0xFFFFFFFF for a 32-bit counter */
+    uint32_t (*get_counter)(void);
+    bool (*set_compare)(uint32_t compare);
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/**
+ * @brief Bind the high resolution timer service to a hardware compare channel and
+ * arm the first compare. The time returned by hr_timer_now() starts from 0.
+ * @param ops The compare channel, it is copied.
+ *
+ * @retval If the compare channel is armed, return true, otherwise return false.
+ */
+extern bool hr_timer_init(const struct hr_timer_ops *ops);
+
+/**
+ * @brief Get the time since hr_timer_init(). The 64-bit time does not wrap.
+ * @param None
+ *
+ * @retval The current time in microseconds.
+ */
+extern uint64_t hr_timer_now(void);
+
+/**
+ * @brief Initialize a timer in the stopped state.
+ * @param timer The timer being initialized.
+ * @param cb The callback function, it is called in the compare interrupt context.
+ * @param user_data The user data which can be got by hr_timer_get_user_data().
+ *
+ * @retval None
+ */
+extern void hr_timer_setup(hr_timer_t timer, hr_timer_cb_t cb, void *user_data);
+
+/**
+ * @brief Start a timer at an absolute deadline. If the timer is already running,
+ * it is moved to the new deadline. A deadline in the past expires on the next
+ * compare interrupt. It can be called in the callback to make a periodic timer
+ * without drift, e.g. hr_timer_start_at(timer, hr_timer_get_deadline(timer) + period).
+ * @param timer The timer being started.
+ * @param deadline The deadline in microseconds on the hr_timer_now() time base.
+ *
+ * @retval If the queue is full, return false, otherwise return true.
+ */
+extern bool hr_timer_start_at(hr_timer_t timer, uint64_t deadline);
+
+/**
+ * @brief Start a timer after a delay from now.
+ * @param timer The timer being started.
+ * @param delay The delay in microseconds.
+ *
+ * @retval If the queue is full, return false, otherwise return true.
+ */
+extern bool hr_timer_start(hr_timer_t timer, uint64_t delay);
+
+/**
+ * @brief Stop a timer, nothing happens if it is not running.
+ * @param timer The timer being stopped.
+ *
+ * @retval None
+ */
+extern void hr_timer_stop(hr_timer_t timer);
+
+/**
+ * @brief Query whether the timer is waiting in the queue.
+ * @param timer The timer being queried.
+ *
+ * @retval If the timer is running, return true, otherwise return false.
+ */
+extern bool hr_timer_is_active(hr_timer_t timer);
+
+/**
+ * @brief Get the last deadline the timer was started at.
+ * @param timer The timer being queried.
+ *
+ * @retval The deadline in microseconds.
+ */
+extern uint64_t hr_timer_get_deadline(hr_timer_t timer);
+
+/**
+ * @brief Get the user data of the timer.
+ * @param timer The timer being queried.
+ *
+ * @retval The user data passed to hr_timer_setup().
+ */
+extern void *hr_timer_get_user_data(hr_timer_t timer);
+
+/**
+ * @brief Run the callbacks of all expired timers and arm the compare channel for
+ * the next one. It must be called in the compare interrupt.
+ * @param None
+ *
+ * @retval None
+ */
+extern void hr_timer_isr(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HR_TIMER_H */
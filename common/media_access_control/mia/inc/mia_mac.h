@@ -33,6 +33,7 @@ extern "C"
 #include <stdbool.h>
 #include <stddef.h>
 #include "mia_phy.h"
+#include "mem_arena.h"
 
 /*---------- macro ----------*/
 /*---------- type define ----------*/
@@ -68,6 +69,12 @@ struct mia_mac_ops {
     void (*bus_fault)(bool fault);
     /* packet parse callback interface */
     void (*receive_packet_parse)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf, uint32_t trans_length);
+    /* Optional, preferred to receive_packet_parse when it is set. The arena hands out
+     * scratch memory which is released when the callback returns, it is NULL if
+     * arena_capacity is 0. */
+    void (*receive_packet_parse_arena)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf,
+                                       uint32_t trans_length, mem_arena_t arena);
+    uint32_t arena_capacity;    /*<< Bytes of scratch memory allocated with the controller */
 };
 
 typedef struct mac *mia_mac_t;
@@ -36,6 +36,16 @@
 #endif
 #endif
 
+/* The mac instance carries the receive buffers, define CONFIG_MIA_MAC_MALLOC to
+ * place it in a fast ram region, e.g. heap_malloc_in(HEAP_REGION_MASK(1), size).
+ */
+#ifndef CONFIG_MIA_MAC_MALLOC
+#define CONFIG_MIA_MAC_MALLOC(size)                 __malloc(size)
+#endif
+#ifndef CONFIG_MIA_MAC_FREE
+#define CONFIG_MIA_MAC_FREE(ptr)                    __free(ptr)
+#endif
+
 /*---------- type define ----------*/
 typedef enum {
     BUS_IDLE = 0,
@@ -86,6 +96,7 @@ struct mac {
     struct mac_transmit transmitter;
     struct mac_process processer;
     struct pingpong_buffer pingpong;
+    struct mem_arena arena;
     struct {
         uint32_t disf;
         bool (*io_init)(void);
@@ -96,6 +107,8 @@ struct mac {
         bool (*event_get)(mia_mac_evt_t *pevt);
         void (*bus_fault)(bool fault);
         void (*receive_packet_parse)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf, uint32_t trans_length);
+        void (*receive_packet_parse_arena)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf,
+                                           uint32_t trans_length, mem_arena_t arena);
     } ops;
 };
 
@@ -103,6 +116,21 @@ struct mac {
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
 /*---------- function ----------*/
+static void _receive_packet_parse(mia_mac_t self, const uint8_t *trans_buf, uint32_t trans_length)
+{
+    arena_mark_t mark = 0;
+
+    if(self->ops.receive_packet_parse_arena) {
+        /* the scratch memory only lives during the callback */
+        mark = arena_mark(&self->arena);
+        self->ops.receive_packet_parse_arena(self->processer.pbuf, self->processer.pos, trans_buf, trans_length,
+                                             (self->arena.capacity ? &self->arena : NULL));
+        arena_reset_to(&self->arena, mark);
+    } else {
+        self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, trans_buf, trans_length);
+    }
+}
+
 static inline uint32_t _pow(uint16_t x)
 {
     uint32_t val = 1;
@@ -194,7 +222,7 @@ mia_mac_t mia_mac_new(uint32_t baudrate, uint32_t recv_capacity, uint32_t trans_
     assert(ops->event_get);
     assert(ops->event_post);
     assert(ops->bus_fault);
-    assert(ops->receive_packet_parse);
+    assert(ops->receive_packet_parse || ops->receive_packet_parse_arena);
     do {
         if(!recv_capacity || !trans_capacity) {
             break;
@@ -202,8 +230,9 @@ mia_mac_t mia_mac_new(uint32_t baudrate, uint32_t recv_capacity, uint32_t trans_
         if(MIA_MAC_EX_NONE != _port_level_init(baudrate, ops)) {
             break;
         }
-        wanted_size = sizeof(*self) + (recv_capacity + sizeof(*preceiver)) * 2 + recv_capacity + trans_capacity;
-        self = __malloc(wanted_size);
+        wanted_size = sizeof(*self) + (recv_capacity + sizeof(*preceiver)) * 2 + recv_capacity + trans_capacity +
+                      ops->arena_capacity;
+        self = CONFIG_MIA_MAC_MALLOC(wanted_size);
         if(!self) {
             break;
         }
@@ -223,12 +252,14 @@ mia_mac_t mia_mac_new(uint32_t baudrate, uint32_t recv_capacity, uint32_t trans_
         self->ops.event_post = ops->event_post;
         self->ops.bus_fault = ops->bus_fault;
         self->ops.receive_packet_parse = ops->receive_packet_parse;
+        self->ops.receive_packet_parse_arena = ops->receive_packet_parse_arena;
         self->ops.disf = (ops->disf ? ops->disf : DISF);
         /* assign pointer */
         recv_buf0 = ((uint8_t *)self) + sizeof(*self);
         recv_buf1 = recv_buf0 + recv_capacity + sizeof(*preceiver);
         self->transmitter.pbuf = recv_buf1 + recv_capacity + sizeof(*preceiver);
         self->processer.pbuf = self->transmitter.pbuf + trans_capacity;
+        arena_init(&self->arena, self->processer.pbuf + recv_capacity, ops->arena_capacity);
         /* register receiver to pingpong buffer */
         preceiver = (struct mac_receive *)recv_buf0;
         preceiver->pbuf = recv_buf0 + sizeof(*preceiver);
@@ -268,7 +299,7 @@ void mia_mac_delete(mia_mac_t self)
     assert(self->phy);
     mia_phy_delete(self->phy);
     self->ops.timer_ctrl(false);
-    __free(self);
+    CONFIG_MIA_MAC_FREE(self);
 }
 
 void mia_mac_set_transmitter(mia_mac_t self, const uint8_t *pbuf, uint32_t length)
@@ -393,7 +424,7 @@ void mia_mac_polling(mia_mac_t self)
 
     assert(self);
     assert(self->ops.event_get);
-    assert(self->ops.receive_packet_parse);
+    assert(self->ops.receive_packet_parse || self->ops.receive_packet_parse_arena);
     assert(self->phy);
     if(self->ops.event_get(&evt)) {
         switch(evt) {
@@ -407,10 +438,9 @@ void mia_mac_polling(mia_mac_t self)
                 self->processer.pos = self->processer.preceiver->pos;
                 pingpong_buffer_set_read_done(&self->pingpong);
                 if(self->transmitter.state == TRANS_WAIT_ACK) {
-                    self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos,
-                            self->transmitter.pbuf, self->transmitter.pos);
+                    _receive_packet_parse(self, self->transmitter.pbuf, self->transmitter.pos);
                 } else {
-                    self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, NULL, 0);
+                    _receive_packet_parse(self, NULL, 0);
                 }
                 break;
             case MIA_MAC_EVT_TRANSMITTER_READY:
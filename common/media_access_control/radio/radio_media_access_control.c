@@ -37,6 +37,16 @@
 #endif
 #endif
 
+/* The mac instance carries the receive buffers, define CONFIG_RADIO_MAC_MALLOC to
+ * place it in a fast ram region, e.g. heap_malloc_in(HEAP_REGION_MASK(1), size).
+ */
+#ifndef CONFIG_RADIO_MAC_MALLOC
+#define CONFIG_RADIO_MAC_MALLOC(size)               __malloc(size)
+#endif
+#ifndef CONFIG_RADIO_MAC_FREE
+#define CONFIG_RADIO_MAC_FREE(ptr)                  __free(ptr)
+#endif
+
 /*---------- type define ----------*/
 typedef enum {
     BUS_IDLE = 0,
@@ -100,6 +110,8 @@ struct mac_ops {
     bool (*event_get)(radio_mac_evt_t *pevt);
     /* packet parse callback interface */
     void (*receive_packet_parse)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf, uint32_t trans_length);
+    void (*receive_packet_parse_arena)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf,
+                                       uint32_t trans_length, mem_arena_t arena);
 };
 
 struct mac {
@@ -109,6 +121,7 @@ struct mac {
     struct mac_responder responder;
     struct mac_process processer;
     struct pingpong_buffer pingpong;
+    struct mem_arena arena;
     struct mac_ops ops;
 };
 
@@ -118,6 +131,21 @@ typedef struct radio_mac_ops *radio_mac_ops_t;
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
 /*---------- function ----------*/
+static void _receive_packet_parse(radio_mac_t self, const uint8_t *trans_buf, uint32_t trans_length)
+{
+    arena_mark_t mark = 0;
+
+    if(self->ops.receive_packet_parse_arena) {
+        /* the scratch memory only lives during the callback */
+        mark = arena_mark(&self->arena);
+        self->ops.receive_packet_parse_arena(self->processer.pbuf, self->processer.pos, trans_buf, trans_length,
+                                             (self->arena.capacity ? &self->arena : NULL));
+        arena_reset_to(&self->arena, mark);
+    } else {
+        self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, trans_buf, trans_length);
+    }
+}
+
 static inline uint32_t _pow(uint16_t x)
 {
     uint32_t val = 1;
@@ -228,7 +256,7 @@ radio_mac_t radio_mac_new(uint32_t recv_capacity, uint32_t trans_capacity, radio
     assert(ops->event_init);
     assert(ops->event_post);
     assert(ops->event_get);
-    assert(ops->receive_packet_parse);
+    assert(ops->receive_packet_parse || ops->receive_packet_parse_arena);
     do {
         if(!recv_capacity || !trans_capacity) {
             break;
@@ -236,8 +264,9 @@ radio_mac_t radio_mac_new(uint32_t recv_capacity, uint32_t trans_capacity, radio
         if(RADIO_MAC_EX_NONE != _port_level_init(ops)) {
             break;
         }
-        wanted_size = sizeof(*self) + (recv_capacity + sizeof(*preceiver)) * 2 + recv_capacity + trans_capacity * 2;
-        self = __malloc(wanted_size);
+        wanted_size = sizeof(*self) + (recv_capacity + sizeof(*preceiver)) * 2 + recv_capacity + trans_capacity * 2 +
+                      ops->arena_capacity;
+        self = CONFIG_RADIO_MAC_MALLOC(wanted_size);
         if(!self) {
             break;
         }
@@ -250,6 +279,7 @@ radio_mac_t radio_mac_new(uint32_t recv_capacity, uint32_t trans_capacity, radio
         self->ops.event_post = ops->event_post;
         self->ops.event_get = ops->event_get;
         self->ops.receive_packet_parse = ops->receive_packet_parse;
+        self->ops.receive_packet_parse_arena = ops->receive_packet_parse_arena;
         self->ops.difs = ops->difs ? ops->difs : DIFS;
         self->ops.bbte = ops->bbte ? ops->bbte : BBTE;
         /* assign pointer */
@@ -258,6 +288,7 @@ radio_mac_t radio_mac_new(uint32_t recv_capacity, uint32_t trans_capacity, radio
         self->transmitter.pbuf = recv_buf1 + recv_capacity + sizeof(*preceiver);
         self->responder.pbuf = self->transmitter.pbuf + trans_capacity;
         self->processer.pbuf = self->responder.pbuf + trans_capacity;
+        arena_init(&self->arena, self->processer.pbuf + recv_capacity, ops->arena_capacity);
         /* register receiver to pingpong buffer */
         preceiver = (struct mac_receive *)recv_buf0;
         preceiver->pbuf = recv_buf0 + sizeof(*preceiver);
@@ -297,7 +328,7 @@ radio_mac_t radio_mac_new(uint32_t recv_capacity, uint32_t trans_capacity, radio
 void radio_mac_delete(radio_mac_t self)
 {
     assert(self);
-    __free(self);
+    CONFIG_RADIO_MAC_FREE(self);
 }
 
 static inline void _set_transmitter(radio_mac_t self, const uint8_t *pbuf, uint32_t length)
@@ -383,7 +414,7 @@ void radio_mac_poll(radio_mac_t self)
     assert(self);
     assert(self->ops.event_get);
     assert(self->ops.radio_receive);
-    assert(self->ops.receive_packet_parse);
+    assert(self->ops.receive_packet_parse || self->ops.receive_packet_parse_arena);
     assert(self->ops.radio_post);
     if(self->ops.event_get(&evt)) {
         switch(evt) {
@@ -399,10 +430,9 @@ void radio_mac_poll(radio_mac_t self)
                     self->processer.pos = self->processer.preceiver->pos;
                     pingpong_buffer_set_read_done(&self->pingpong);
                     if(self->transmitter.state == TRANS_WAIT_ACK) {
-                        self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos,
-                                self->transmitter.pbuf, self->transmitter.pos);
+                        _receive_packet_parse(self, self->transmitter.pbuf, self->transmitter.pos);
                     } else {
-                        self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, NULL, 0);
+                        _receive_packet_parse(self, NULL, 0);
                     }
                 }
                 break;
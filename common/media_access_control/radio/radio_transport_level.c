@@ -26,8 +26,17 @@
 #include "lists.h"
 #include "options.h"
 #include <string.h>
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+#include "mem_pool.h"
+#endif
 
 /*---------- macro ----------*/
+/* frames whose payload is not bigger than this size are cached in the pool,
+ * bigger frames are still allocated from the heap */
+#ifndef CONFIG_RADIO_TRANSPORT_POOL_FRAME_SIZE
+#define CONFIG_RADIO_TRANSPORT_POOL_FRAME_SIZE    (64)
+#endif
+
 /*---------- type define ----------*/
 typedef struct node *node_t;
 struct node {
@@ -35,6 +44,9 @@ struct node {
     uint8_t *pbuf;
     uint32_t length;
     uint32_t retrans_max_count;
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+    bool pooled;
+#endif
 };
 
 struct transport_ops {
@@ -49,6 +61,9 @@ struct transport {
     radio_mac_t handle;
     struct list_head head;
     struct transport_ops ops;
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+    mem_pool_t pool;
+#endif
 };
 
 typedef struct radio_transport_ops *transport_ops_t;
@@ -71,6 +86,49 @@ static inline void _unlock(radio_transport_t self)
     }
 }
 
+static node_t _node_alloc(radio_transport_t self, uint32_t length)
+{
+    node_t n = NULL;
+    uint32_t wanted_size = length + sizeof(*n);
+
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+    if(self->pool && length <= CONFIG_RADIO_TRANSPORT_POOL_FRAME_SIZE) {
+        n = mem_pool_alloc(self->pool);
+    }
+    if(n) {
+        memset(n, 0, wanted_size);
+        n->pooled = true;
+    } else if(NULL != (n = __malloc(wanted_size))) {
+        memset(n, 0, wanted_size);
+    }
+#else
+    (void)self;
+    n = __malloc(wanted_size);
+    if(n) {
+        memset(n, 0, wanted_size);
+    }
+#endif
+    if(n) {
+        n->pbuf = ((uint8_t *)n) + sizeof(*n);
+    }
+
+    return n;
+}
+
+static void _node_free(radio_transport_t self, node_t n)
+{
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+    if(n->pooled) {
+        mem_pool_free(self->pool, n);
+    } else {
+        __free(n);
+    }
+#else
+    (void)self;
+    __free(n);
+#endif
+}
+
 static inline void _del_repeat(radio_transport_t self, node_t new_node)
 {
     node_t pos = NULL, n = NULL;
@@ -83,7 +141,7 @@ static inline void _del_repeat(radio_transport_t self, node_t new_node)
                 if(self->cur_blocked_count) {
                     self->cur_blocked_count--;
                 }
-                __free(pos);
+                _node_free(self, pos);
             }
         }
     }
@@ -111,7 +169,13 @@ radio_transport_t radio_transport_new(uint32_t recv_capacity, uint32_t trans_cap
         if(!self->handle) {
             __free(self);
             self = NULL;
+            break;
         }
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+        /* frames fall back to the heap if the pool can not be created */
+        self->pool = mem_pool_create(sizeof(struct node) + CONFIG_RADIO_TRANSPORT_POOL_FRAME_SIZE,
+                max_blocked_count ? max_blocked_count : 1);
+#endif
     } while(0);
 
     return self;
@@ -125,11 +189,16 @@ void radio_transport_delete(radio_transport_t self)
     while(!list_empty_careful(&self->head)) {
         node_t n = list_first_entry(&self->head, struct node, node);
         list_del(&n->node);
-        __free(n);
+        _node_free(self, n);
     }
     self->cur_blocked_count = 0;
     _unlock(self);
     radio_mac_delete(self->handle);
+#ifdef CONFIG_RADIO_TRANSPORT_USE_MEM_POOL
+    if(self->pool) {
+        mem_pool_delete(self->pool);
+    }
+#endif
     __free(self);
 }
 
@@ -144,7 +213,6 @@ radio_transport_expection_t radio_transport_set_transmitter_cache(radio_transpor
         uint32_t length, uint16_t retrans_count)
 {
     radio_transport_expection_t err = RADIO_TRANSPORT_EX_MEMORY_EMPTY;
-    uint32_t wanted_size = 0;
     node_t n = NULL;
 
     assert(self);
@@ -158,13 +226,10 @@ radio_transport_expection_t radio_transport_set_transmitter_cache(radio_transpor
             self->cur_blocked_count = 0;
             _unlock(self);
         }
-        wanted_size = length + sizeof(*n);
-        n = __malloc(wanted_size);
+        n = _node_alloc(self, length);
         if(!n) {
             break;
         }
-        memset(n, 0, wanted_size);
-        n->pbuf = ((uint8_t *)n) + sizeof(*n);
         memcpy(n->pbuf, pbuf, length);
         n->length = length;
         n->retrans_max_count = retrans_count;
@@ -197,7 +262,7 @@ void radio_transport_drop_transmitter_cache(radio_transport_t self)
         if(self->cur_blocked_count) {
             self->cur_blocked_count--;
         }
-        __free(n);
+        _node_free(self, n);
     }
     _unlock(self);
 }
@@ -222,7 +287,7 @@ void radio_transport_poll(radio_transport_t self)
             if(self->cur_blocked_count) {
                 self->cur_blocked_count--;
             }
-            __free(n);
+            _node_free(self, n);
         }
     }
     _unlock(self);
@@ -37,6 +37,16 @@
 #endif
 #endif
 
+/* The mac instance carries the receive buffers, define CONFIG_SERIAL_MAC_MALLOC to
+ * place it in a fast ram region, e.g. heap_malloc_in(HEAP_REGION_MASK(1), size).
+ */
+#ifndef CONFIG_SERIAL_MAC_MALLOC
+#define CONFIG_SERIAL_MAC_MALLOC(size)              __malloc(size)
+#endif
+#ifndef CONFIG_SERIAL_MAC_FREE
+#define CONFIG_SERIAL_MAC_FREE(ptr)                 __free(ptr)
+#endif
+
 /*---------- type define ----------*/
 typedef enum {
     BUS_IDLE = 0,
@@ -102,6 +112,8 @@ struct mac_ops {
     bool (*event_get)(serial_mac_evt_t *pevt);
     /* receive callback interface */
     void (*receive_packet_parse)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf, uint32_t trans_length);
+    void (*receive_packet_parse_arena)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf,
+                                       uint32_t trans_length, mem_arena_t arena);
 };
 
 struct mac {
@@ -110,6 +122,7 @@ struct mac {
     struct mac_transmit transmitter;
     struct mac_process processer;
     struct pingpong_buffer pingpong;
+    struct mem_arena arena;
     struct mac_ops ops;
 };
 
@@ -119,6 +132,21 @@ typedef struct serial_mac_ops *serial_mac_ops_t;
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
 /*---------- function ----------*/
+static void _receive_packet_parse(serial_mac_t self, const uint8_t *trans_buf, uint32_t trans_length)
+{
+    arena_mark_t mark = 0;
+
+    if(self->ops.receive_packet_parse_arena) {
+        /* the scratch memory only lives during the callback */
+        mark = arena_mark(&self->arena);
+        self->ops.receive_packet_parse_arena(self->processer.pbuf, self->processer.pos, trans_buf, trans_length,
+                                             (self->arena.capacity ? &self->arena : NULL));
+        arena_reset_to(&self->arena, mark);
+    } else {
+        self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, trans_buf, trans_length);
+    }
+}
+
 static inline uint32_t _pow(uint16_t x)
 {
     uint32_t val = 1;
@@ -217,7 +245,7 @@ serial_mac_t halfduplex_serial_media_access_controller_new(uint32_t baudrate, ui
     assert(ops->halfduplex.event_init);
     assert(ops->halfduplex.event_post);
     assert(ops->halfduplex.event_get);
-    assert(ops->receive_packet_parse);
+    assert(ops->receive_packet_parse || ops->receive_packet_parse_arena);
     do {
         if(!recv_capacity || !trans_capacity) {
             break;
@@ -225,8 +253,9 @@ serial_mac_t halfduplex_serial_media_access_controller_new(uint32_t baudrate, ui
         if(SERIAL_MAC_EX_NONE != _port_level_init(baudrate, ops)) {
             break;
         }
-        alloc_length = sizeof(*self) + (recv_capacity + sizeof(*preceiver)) * 2 + recv_capacity + trans_capacity;
-        self = __malloc(alloc_length);
+        alloc_length = sizeof(*self) + (recv_capacity + sizeof(*preceiver)) * 2 + recv_capacity + trans_capacity +
+                       ops->arena_capacity;
+        self = CONFIG_SERIAL_MAC_MALLOC(alloc_length);
         if(!self) {
             break;
         }
@@ -241,6 +270,7 @@ serial_mac_t halfduplex_serial_media_access_controller_new(uint32_t baudrate, ui
         self->ops.event_post = ops->halfduplex.event_post;
         self->ops.event_get = ops->halfduplex.event_get;
         self->ops.receive_packet_parse = ops->receive_packet_parse;
+        self->ops.receive_packet_parse_arena = ops->receive_packet_parse_arena;
         self->ops.difs = ops->halfduplex.difs ? ops->halfduplex.difs : DIFS;
         self->ops.tx_type = ops->halfduplex.tx_type;
         /* assign pointer */
@@ -248,6 +278,7 @@ serial_mac_t halfduplex_serial_media_access_controller_new(uint32_t baudrate, ui
         recv_buf1 = recv_buf0 + recv_capacity + sizeof(*preceiver);
         self->transmitter.pbuf = recv_buf1 + recv_capacity + sizeof(*preceiver);
         self->processer.pbuf = self->transmitter.pbuf + trans_capacity;
+        arena_init(&self->arena, self->processer.pbuf + recv_capacity, ops->arena_capacity);
         /* register receiver to pingpong buffer */
         preceiver = (struct mac_receive *)recv_buf0;
         preceiver->pbuf = recv_buf0 + sizeof(*preceiver);
@@ -286,7 +317,7 @@ void halfduplex_serial_media_access_controller_delete(serial_mac_t self)
     assert(self);
     assert(self->ops.timer_ctrl);
     self->ops.timer_ctrl(false);
-    __free(self);
+    CONFIG_SERIAL_MAC_FREE(self);
 }
 
 void halfduplex_serial_mac_set_transmitter(serial_mac_t self, const uint8_t *pbuf, uint32_t length)
@@ -411,7 +442,7 @@ void halfduplex_serial_mac_poll(serial_mac_t self)
     assert(self);
     assert(self->ops.event_get);
     assert(self->ops.serial_post);
-    assert(self->ops.receive_packet_parse);
+    assert(self->ops.receive_packet_parse || self->ops.receive_packet_parse_arena);
     if(self->ops.event_get(&evt)) {
         switch(evt) {
             case SERIAL_MAC_EVT_RECEIVED:
@@ -424,10 +455,9 @@ void halfduplex_serial_mac_poll(serial_mac_t self)
                 self->processer.pos = self->processer.preceiver->pos;
                 pingpong_buffer_set_read_done(&self->pingpong);
                 if(self->transmitter.state == TRANS_WAIT_ACK) {
-                    self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, 
-                            self->transmitter.pbuf, self->transmitter.pos);
+                    _receive_packet_parse(self, self->transmitter.pbuf, self->transmitter.pos);
                 } else {
-                    self->ops.receive_packet_parse(self->processer.pbuf, self->processer.pos, NULL, 0);
+                    _receive_packet_parse(self, NULL, 0);
                 }
                 break;
             case SERIAL_MAC_EVT_TRANSMITTER_READY:
@@ -32,6 +32,7 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "mem_arena.h"
 
 /*---------- macro ----------*/
 /*---------- type define ----------*/
@@ -95,6 +96,12 @@ struct serial_mac_ops {
         struct halfduplex_serial_mac_ops halfduplex;
         struct fullduplex_serial_mac_ops fullduplex;
     };
+    /* Optional, preferred to receive_packet_parse when it is set. The arena hands out
+     * scratch memory which is released when the callback returns, it is NULL if
+     * arena_capacity is 0. */
+    void (*receive_packet_parse_arena)(const uint8_t *recv_buf, uint32_t recv_length, const uint8_t *trans_buf,
+                                       uint32_t trans_length, mem_arena_t arena);
+    uint32_t arena_capacity;    /*<< Bytes of scratch memory allocated with the controller */
 };
 
 /*---------- variable prototype ----------*/
@@ -26,8 +26,17 @@
 #include "lists.h"
 #include "options.h"
 #include <string.h>
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+#include "mem_pool.h"
+#endif
 
 /*---------- macro ----------*/
+/* frames whose payload is not bigger than this size are cached in the pool,
+ * bigger frames are still allocated from the heap */
+#ifndef CONFIG_SERIAL_TRANSPORT_POOL_FRAME_SIZE
+#define CONFIG_SERIAL_TRANSPORT_POOL_FRAME_SIZE    (64)
+#endif
+
 /*---------- type define ----------*/
 typedef struct node *node_t;
 struct node {
@@ -35,6 +44,9 @@ struct node {
     uint8_t *pbuf;
     uint32_t length;
     uint32_t retrans_max_count;
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+    bool pooled;
+#endif
     uint32_t wait_ack_ticks;
 };
 
@@ -49,6 +61,9 @@ struct transport {
     serial_mac_t handle;
     struct list_head head;
     struct transport_ops ops;
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+    mem_pool_t pool;
+#endif
 };
 
 typedef struct serial_transport_ops *transport_ops_t;
@@ -71,6 +86,49 @@ static inline void _unlock(serial_transport_t self)
     }
 }
 
+static node_t _node_alloc(serial_transport_t self, uint32_t length)
+{
+    node_t n = NULL;
+    uint32_t wanted_size = length + sizeof(*n);
+
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+    if(self->pool && length <= CONFIG_SERIAL_TRANSPORT_POOL_FRAME_SIZE) {
+        n = mem_pool_alloc(self->pool);
+    }
+    if(n) {
+        memset(n, 0, wanted_size);
+        n->pooled = true;
+    } else if(NULL != (n = __malloc(wanted_size))) {
+        memset(n, 0, wanted_size);
+    }
+#else
+    (void)self;
+    n = __malloc(wanted_size);
+    if(n) {
+        memset(n, 0, wanted_size);
+    }
+#endif
+    if(n) {
+        n->pbuf = ((uint8_t *)n) + sizeof(*n);
+    }
+
+    return n;
+}
+
+static void _node_free(serial_transport_t self, node_t n)
+{
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+    if(n->pooled) {
+        mem_pool_free(self->pool, n);
+    } else {
+        __free(n);
+    }
+#else
+    (void)self;
+    __free(n);
+#endif
+}
+
 serial_transport_t serial_transport_new(serial_mac_type_t type, uint32_t baudrate, uint32_t recv_capacity,
         uint32_t trans_capacity, uint32_t max_blocked_count, transport_ops_t ops)
 {
@@ -95,7 +153,13 @@ serial_transport_t serial_transport_new(serial_mac_type_t type, uint32_t baudrat
         if(!self->handle) {
             __free(self);
             self = NULL;
+            break;
         }
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+        /* frames fall back to the heap if the pool can not be created */
+        self->pool = mem_pool_create(sizeof(struct node) + CONFIG_SERIAL_TRANSPORT_POOL_FRAME_SIZE,
+                max_blocked_count ? max_blocked_count : 1);
+#endif
     } while(0);
 
     return self;
@@ -109,11 +173,16 @@ void serial_transport_delete(serial_transport_t self)
     while(!list_empty_careful(&self->head)) {
         node_t n = list_first_entry(&self->head, struct node, node);
         list_del(&n->node);
-        __free(n);
+        _node_free(self, n);
     }
     self->cur_blocked_count = 0;
     _unlock(self);
     serial_mac_delete(self->handle);
+#ifdef CONFIG_SERIAL_TRANSPORT_USE_MEM_POOL
+    if(self->pool) {
+        mem_pool_delete(self->pool);
+    }
+#endif
     __free(self);
 }
 
@@ -128,7 +197,6 @@ serial_transport_expection_t serial_transport_set_transmitter_cache(serial_trans
         uint32_t length, uint16_t retrans_count, uint32_t wait_ack_ticks)
 {
     serial_transport_expection_t err = SERIAL_TRANSPORT_EX_MEMORY_EMPTY;
-    uint32_t alloc_length = 0;
     node_t n = NULL;
 
     assert(self);
@@ -142,13 +210,10 @@ serial_transport_expection_t serial_transport_set_transmitter_cache(serial_trans
             self->cur_blocked_count = 0;
             _unlock(self);
         }
-        alloc_length = length + sizeof(*n);
-        n = __malloc(alloc_length);
+        n = _node_alloc(self, length);
         if(!n) {
             break;
         }
-        memset(n, 0, alloc_length);
-        n->pbuf = ((uint8_t *)n) + sizeof(*n);
         memcpy(n->pbuf, pbuf, length);
         n->length = length;
         n->retrans_max_count = retrans_count;
@@ -181,7 +246,7 @@ void serial_transport_drop_transmitter_cache(serial_transport_t self)
         if(self->cur_blocked_count) {
             self->cur_blocked_count--;
         }
-        __free(n);
+        _node_free(self, n);
     }
     _unlock(self);
 }
@@ -214,7 +279,7 @@ void serial_transport_poll(serial_transport_t self)
             if(self->cur_blocked_count) {
                 self->cur_blocked_count--;
             }
-            __free(n);
+            _node_free(self, n);
         }
     }
     _unlock(self);
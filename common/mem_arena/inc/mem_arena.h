@@ -0,0 +1,111 @@
+/**
+ * @file common/mem_arena/inc/mem_arena.h
+ *
+ * Copyright (C) 2024
+ *
+ * mem_arena.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+#ifndef __MEM_ARENA_H
+#define __MEM_ARENA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*---------- macro ----------*/
+/*---------- type define ----------*/
+typedef struct mem_arena *mem_arena_t;
+struct mem_arena {
+    uint8_t *pbuf;
+    uint32_t capacity;
+    uint32_t offset;            /*<< The first unused byte of pbuf */
+    uint32_t high_water;        /*<< Maximum offset since the arena was initialized */
+};
+
+/* A position of the arena returned by arena_mark(). */
+typedef uint32_t arena_mark_t;
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/**
+ * @brief Initialize an arena on caller-supplied memory. The arena does not own the
+ * memory and never calls the heap.
+ * @param self The arena being initialized.
+ * @param pbuf The memory managed by the arena.
+ * @param capacity The size of pbuf in bytes.
+ *
+ * @retval None
+ */
+extern void arena_init(mem_arena_t self, void *pbuf, uint32_t capacity);
+
+/**
+ * @brief Allocate memory from the arena by moving the offset forward, no header is
+ * placed in front of the memory, so it can not be freed one by one. The memory is
+ * released by arena_reset_to() or arena_reset().
+ * @param self The arena.
+ * @param size The size of memory.
+ *
+ * @retval A pointer aligned to CONFIG_MEM_ARENA_BYTE_ALIGNMENT or NULL if the arena
+ * is exhausted.
+ */
+extern void *arena_alloc(mem_arena_t self, uint32_t size);
+
+/**
+ * @brief Remember the current position of the arena.
+ * @param self The arena.
+ *
+ * @retval The mark which is passed to arena_reset_to().
+ */
+extern arena_mark_t arena_mark(mem_arena_t self);
+
+/**
+ * @brief Release all memory allocated after the mark was taken.
+ * @param self The arena.
+ * @param mark The mark returned by arena_mark().
+ *
+ * @retval None
+ */
+extern void arena_reset_to(mem_arena_t self, arena_mark_t mark);
+
+/**
+ * @brief Release all memory of the arena.
+ * @param self The arena.
+ *
+ * @retval None
+ */
+extern void arena_reset(mem_arena_t self);
+
+/**
+ * @brief Query the bytes which can still be allocated, the alignment padding of the
+ * next allocation is not subtracted.
+ * @param self The arena.
+ *
+ * @retval The free bytes of the arena.
+ */
+extern uint32_t arena_get_free_size(mem_arena_t self);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __MEM_ARENA_H */
@@ -0,0 +1,94 @@
+/**
+ * @file common/mem_arena/mem_arena.c
+ *
+ * Copyright (C) 2024
+ *
+ * mem_arena.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "mem_arena.h"
+#include "options.h"
+
+/*---------- macro ----------*/
+#ifndef CONFIG_MEM_ARENA_BYTE_ALIGNMENT
+#define CONFIG_MEM_ARENA_BYTE_ALIGNMENT     (sizeof(void *))
+#endif
+
+#define MEM_ARENA_ALIGNMENT_MASK            ((uintptr_t)CONFIG_MEM_ARENA_BYTE_ALIGNMENT - 1)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+/*---------- function ----------*/
+void arena_init(mem_arena_t self, void *pbuf, uint32_t capacity)
+{
+    assert(self);
+    assert(pbuf || !capacity);
+    self->pbuf = (uint8_t *)pbuf;
+    self->capacity = capacity;
+    self->offset = 0;
+    self->high_water = 0;
+}
+
+void *arena_alloc(mem_arena_t self, uint32_t size)
+{
+    void *ptr = NULL;
+    uint32_t padding = 0;
+
+    assert(self);
+    /* align the address rather than the offset, the memory may be unaligned */
+    padding = (uint32_t)((CONFIG_MEM_ARENA_BYTE_ALIGNMENT -
+                          (((uintptr_t)self->pbuf + self->offset) & MEM_ARENA_ALIGNMENT_MASK)) & MEM_ARENA_ALIGNMENT_MASK);
+    if(size && padding <= (self->capacity - self->offset) &&
+       size <= (self->capacity - self->offset - padding)) {
+        ptr = self->pbuf + self->offset + padding;
+        self->offset += padding + size;
+        if(self->high_water < self->offset) {
+            self->high_water = self->offset;
+        }
+    }
+
+    return ptr;
+}
+
+arena_mark_t arena_mark(mem_arena_t self)
+{
+    assert(self);
+    return self->offset;
+}
+
+void arena_reset_to(mem_arena_t self, arena_mark_t mark)
+{
+    assert(self);
+    assert(mark <= self->offset);
+    self->offset = mark;
+}
+
+void arena_reset(mem_arena_t self)
+{
+    assert(self);
+    self->offset = 0;
+}
+
+uint32_t arena_get_free_size(mem_arena_t self)
+{
+    assert(self);
+    return self->capacity - self->offset;
+}
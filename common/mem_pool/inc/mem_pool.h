@@ -0,0 +1,121 @@
+/**
+ * @file common/mem_pool/inc/mem_pool.h
+ *
+ * Copyright (C) 2024
+ *
+ * mem_pool.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+#ifndef __MEM_POOL_H
+#define __MEM_POOL_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*---------- macro ----------*/
+/*---------- type define ----------*/
+/* A pool is protected by CONFIG_MEM_POOL_LOCK()/CONFIG_MEM_POOL_UNLOCK(), they default to
+ * __enter_critical()/__exit_critical(). The heap is never called with the lock held. */
+typedef struct mem_pool *mem_pool_t;
+
+typedef struct mem_pool_stats *mem_pool_stats_t;
+struct mem_pool_stats {
+    uint32_t object_size;       /*<< Size of every object after alignment */
+    uint32_t chunk_count;       /*<< Number of chunks allocated from the heap */
+    uint32_t total_count;       /*<< Number of objects the chunks can hold */
+    uint32_t used_count;        /*<< Number of objects in use */
+    uint32_t high_water;        /*<< Maximum number of objects in use at the same time */
+    uint32_t failed_count;      /*<< Number of allocations failed because the heap was exhausted */
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/**
+ * @brief Create a fixed-size object pool, and return a handle by which the created
+ * pool can be referenced.
+ * The pool does not allocate any object memory until the first mem_pool_alloc(), then
+ * it grows by a chunk of count objects each time it runs out of free objects.
+ * @param obj_size The size of every object in the pool.
+ * @param count Number of objects in a chunk.
+ *
+ * @retval If the pool is successfully created then a handle to the newly pool is returned.
+ * If the pool cannot be created because there is insufficient heap remaining to allocate
+ * the pool structure, or a chunk would exceed 4 GiB, then NULL is returned.
+ */
+extern mem_pool_t mem_pool_create(uint32_t obj_size, uint32_t count);
+
+/**
+ * @brief Return the pool stored in *ppool, the pool is created by the first call. Concurrent
+ * first calls return the same pool, so a pool shared by all instances of a module can be
+ * created on demand.
+ * @param ppool The pointer to the variable holding the pool, it must be NULL initially.
+ * @param obj_size The size of every object in the pool.
+ * @param count Number of objects in a chunk.
+ *
+ * @retval The pool, or NULL if it cannot be created because there is insufficient heap
+ * remaining, the next call tries again.
+ */
+extern mem_pool_t mem_pool_get_or_create(mem_pool_t *ppool, uint32_t obj_size, uint32_t count);
+
+/**
+ * @brief Delete a pool that was previously created using the mem_pool_create() API function.
+ * All chunks are returned to the heap, the objects allocated from the pool must no longer
+ * be used.
+ * @param self The handle of the pool being deleted.
+ *
+ * @retval None
+ */
+extern void mem_pool_delete(mem_pool_t self);
+
+/**
+ * @brief Allocate an object from the pool.
+ * @param self The handle of the pool.
+ *
+ * @retval If there is a free object or the pool can grow then a pointer to the object is
+ * returned. Otherwise NULL is returned.
+ */
+extern void *mem_pool_alloc(mem_pool_t self);
+
+/**
+ * @brief Return an object to the pool.
+ * @param self The handle of the pool.
+ * @param ptr The object which was allocated from the same pool by mem_pool_alloc().
+ *
+ * @retval None
+ */
+extern void mem_pool_free(mem_pool_t self, void *ptr);
+
+/**
+ * @brief Query the statistics of the pool.
+ * @param self The handle of the pool being queried.
+ * @param stats The container for storing statistics.
+ *
+ * @retval None
+ */
+extern void mem_pool_get_stats(mem_pool_t self, mem_pool_stats_t stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __MEM_POOL_H */
@@ -0,0 +1,231 @@
+/**
+ * @file common/mem_pool/mem_pool.c
+ *
+ * Copyright (C) 2024
+ *
+ * mem_pool.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "mem_pool.h"
+#include "options.h"
+#include <string.h>
+
+/*---------- macro ----------*/
+/* pool protect callback definition, a pool is shared by all instances of its user and
+ * may be used from an ISR, define both as empty to drop the lock of a single thread build */
+#ifndef CONFIG_MEM_POOL_LOCK
+#define CONFIG_MEM_POOL_LOCK()              __enter_critical()
+#endif
+
+#ifndef CONFIG_MEM_POOL_UNLOCK
+#define CONFIG_MEM_POOL_UNLOCK()            __exit_critical()
+#endif
+
+#ifndef CONFIG_MEM_POOL_BYTE_ALIGNMENT
+#define CONFIG_MEM_POOL_BYTE_ALIGNMENT      (sizeof(void *))
+#endif
+
+#define MEM_POOL_ALIGN_UP(x)                (((x) + (CONFIG_MEM_POOL_BYTE_ALIGNMENT - 1)) & \
+                                             ~((uint32_t)CONFIG_MEM_POOL_BYTE_ALIGNMENT - 1))
+#define MEM_POOL_CHUNK_HEADER_SIZE          MEM_POOL_ALIGN_UP((uint32_t)sizeof(struct chunk))
+
+/*---------- type define ----------*/
+struct chunk {
+    struct chunk *next;
+};
+
+struct object {
+    struct object *next;
+};
+
+struct mem_pool {
+    uint32_t chunk_capacity;
+    struct chunk *chunks;
+    struct object *free_list;
+    /* the unused tail of the newest chunk, objects are carved from it on demand
+     * so that growing the pool does not need to walk the whole chunk */
+    uint8_t *pbump;
+    uint32_t bump_count;
+    struct mem_pool_stats stats;
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+/*---------- function ----------*/
+/* Called without the pool lock, so the heap lock is never taken inside it. */
+static struct chunk *_chunk_new(mem_pool_t self)
+{
+    return __malloc(MEM_POOL_CHUNK_HEADER_SIZE + self->stats.object_size * self->chunk_capacity);
+}
+
+static void _chunk_link(mem_pool_t self, struct chunk *chunk)
+{
+    chunk->next = self->chunks;
+    self->chunks = chunk;
+    self->pbump = (uint8_t *)chunk + MEM_POOL_CHUNK_HEADER_SIZE;
+    self->bump_count = self->chunk_capacity;
+    self->stats.chunk_count++;
+    self->stats.total_count += self->chunk_capacity;
+}
+
+static void *_take(mem_pool_t self)
+{
+    void *ptr = NULL;
+
+    if(self->free_list) {
+        ptr = self->free_list;
+        self->free_list = self->free_list->next;
+    } else if(self->bump_count) {
+        ptr = self->pbump;
+        self->pbump += self->stats.object_size;
+        self->bump_count--;
+    }
+
+    return ptr;
+}
+
+mem_pool_t mem_pool_create(uint32_t obj_size, uint32_t count)
+{
+    mem_pool_t self = NULL;
+
+    assert(obj_size);
+    assert(count);
+    do {
+        if(obj_size < sizeof(struct object)) {
+            obj_size = sizeof(struct object);
+        }
+        /* The size of a chunk must not wrap around in uint32_t. */
+        if(obj_size > UINT32_MAX - (CONFIG_MEM_POOL_BYTE_ALIGNMENT - 1)) {
+            break;
+        }
+        obj_size = MEM_POOL_ALIGN_UP(obj_size);
+        if(count > (UINT32_MAX - MEM_POOL_CHUNK_HEADER_SIZE) / obj_size) {
+            break;
+        }
+        self = __malloc(sizeof(*self));
+        if(self) {
+            memset(self, 0, sizeof(*self));
+            self->stats.object_size = obj_size;
+            self->chunk_capacity = count;
+        }
+    } while(0);
+
+    return self;
+}
+
+void mem_pool_delete(mem_pool_t self)
+{
+    struct chunk *chunk = NULL;
+
+    assert(self);
+    while(self->chunks) {
+        chunk = self->chunks;
+        self->chunks = chunk->next;
+        __free(chunk);
+    }
+    __free(self);
+}
+
+mem_pool_t mem_pool_get_or_create(mem_pool_t *ppool, uint32_t obj_size, uint32_t count)
+{
+    mem_pool_t pool = NULL, created = NULL;
+
+    assert(ppool);
+    CONFIG_MEM_POOL_LOCK();
+    pool = *ppool;
+    CONFIG_MEM_POOL_UNLOCK();
+    if(!pool) {
+        /* Created outside the lock as it allocates from the heap, the loser of a
+         * concurrent first creation deletes its own pool. */
+        created = mem_pool_create(obj_size, count);
+        CONFIG_MEM_POOL_LOCK();
+        if(!*ppool) {
+            *ppool = created;
+            created = NULL;
+        }
+        pool = *ppool;
+        CONFIG_MEM_POOL_UNLOCK();
+        if(created) {
+            mem_pool_delete(created);
+        }
+    }
+
+    return pool;
+}
+
+void *mem_pool_alloc(mem_pool_t self)
+{
+    void *ptr = NULL;
+    struct chunk *chunk = NULL;
+
+    assert(self);
+    CONFIG_MEM_POOL_LOCK();
+    ptr = _take(self);
+    if(!ptr) {
+        CONFIG_MEM_POOL_UNLOCK();
+        chunk = _chunk_new(self);
+        CONFIG_MEM_POOL_LOCK();
+        /* Another thread may have freed an object or grown the pool meanwhile. */
+        ptr = _take(self);
+        if(!ptr && chunk) {
+            _chunk_link(self, chunk);
+            chunk = NULL;
+            ptr = _take(self);
+        }
+        if(!ptr) {
+            self->stats.failed_count++;
+        }
+    }
+    if(ptr) {
+        self->stats.used_count++;
+        if(self->stats.high_water < self->stats.used_count) {
+            self->stats.high_water = self->stats.used_count;
+        }
+    }
+    CONFIG_MEM_POOL_UNLOCK();
+    if(chunk) {
+        __free(chunk);
+    }
+
+    return ptr;
+}
+
+void mem_pool_free(mem_pool_t self, void *ptr)
+{
+    struct object *obj = (struct object *)ptr;
+
+    assert(self);
+    if(obj) {
+        CONFIG_MEM_POOL_LOCK();
+        obj->next = self->free_list;
+        self->free_list = obj;
+        self->stats.used_count--;
+        CONFIG_MEM_POOL_UNLOCK();
+    }
+}
+
+void mem_pool_get_stats(mem_pool_t self, mem_pool_stats_t stats)
+{
+    assert(self);
+    assert(stats);
+    CONFIG_MEM_POOL_LOCK();
+    *stats = self->stats;
+    CONFIG_MEM_POOL_UNLOCK();
+}
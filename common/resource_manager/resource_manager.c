@@ -26,10 +26,17 @@
 #include "lists.h"
 #include "options.h"
 #include <string.h>
+#ifdef CONFIG_RESOURCE_MANAGER_USE_MEM_POOL
+#include "mem_pool.h"
+#endif
 
 /*---------- macro ----------*/
 #define TAG                                         "ResourceManager"
 
+#ifndef CONFIG_RESOURCE_MANAGER_POOL_CHUNK_COUNT
+#define CONFIG_RESOURCE_MANAGER_POOL_CHUNK_COUNT    (8)
+#endif
+
 /*---------- type define ----------*/
 typedef struct resource_manager *resource_manager_t;
 struct resource_manager {
@@ -48,7 +55,32 @@ struct resource_node {
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
+#ifdef CONFIG_RESOURCE_MANAGER_USE_MEM_POOL
+static mem_pool_t _node_pool;                       /*<< Fixed-size pool of resource nodes shared by all managers */
+#endif
+
 /*---------- function ----------*/
+static resource_node_t _node_alloc(void)
+{
+#ifdef CONFIG_RESOURCE_MANAGER_USE_MEM_POOL
+    mem_pool_t pool = mem_pool_get_or_create(&_node_pool, sizeof(struct resource_node),
+                                             CONFIG_RESOURCE_MANAGER_POOL_CHUNK_COUNT);
+
+    return (pool ? mem_pool_alloc(pool) : NULL);
+#else
+    return __malloc(sizeof(struct resource_node));
+#endif
+}
+
+static void _node_free(resource_node_t node)
+{
+#ifdef CONFIG_RESOURCE_MANAGER_USE_MEM_POOL
+    mem_pool_free(_node_pool, node);
+#else
+    __free(node);
+#endif
+}
+
 static bool inline __match_by_name(const char *src, const char *dst)
 {
     return (strcmp(src, dst) == 0);
@@ -80,7 +112,7 @@ static bool _add_resource(const resource_manager_base_t base, const char *name,
             xlog_tag_error(TAG, "base is invalid, add resource failed\n");
             break;
         }
-        node = __malloc(sizeof(struct resource_node));
+        node = _node_alloc();
         if(node == NULL) {
             xlog_tag_error(TAG, "No enough memory to add resource\n");
             break;
@@ -89,6 +121,7 @@ static bool _add_resource(const resource_manager_base_t base, const char *name,
         memset(node, 0, sizeof(struct resource_node));
         if(_search_node(manager, name, node)) {
             xlog_tag_warn(TAG, "%s was registered\n", name);
+            _node_free(node);
             break;
         }
         node->name = name;
@@ -119,7 +152,7 @@ static bool _remove_resource(const resource_manager_base_t base, const char *nam
         }
         list = node.node.next->prev;
         list_del(list);
-        __free(list_entry(list, struct resource_node, node));
+        _node_free(list_entry(list, struct resource_node, node));
         xlog_tag_message(TAG, "%s remove success\n", name);
         retval = true;
     } while(0);
@@ -220,7 +253,7 @@ void resource_manager_destroy(resource_manager_base_t base)
         if(list_empty(&manager->head) != true) {
             list_for_each_entry_safe(p, n, struct resource_node, &manager->head, node) {
                 list_del(&p->node);
-                __free(p);
+                _node_free(p);
             }
         }
         __free(manager);
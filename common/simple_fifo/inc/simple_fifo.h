@@ -34,15 +34,50 @@ extern "C"
 #include <stddef.h>
 
 /*---------- macro ----------*/
+#define __SIMPLE_FIFO_OR_SHIFT(x, n)                ((x) | ((x) >> (n)))
+
+/* Round x up to a power of two in a constant expression. */
+#define SIMPLE_FIFO_ROUND_UP_POWER_OF_TWO(x)        (__SIMPLE_FIFO_OR_SHIFT(__SIMPLE_FIFO_OR_SHIFT(__SIMPLE_FIFO_OR_SHIFT( \
+                                                     __SIMPLE_FIFO_OR_SHIFT(__SIMPLE_FIFO_OR_SHIFT(                     \
+                                                     (uint32_t)(x) - 1U, 1), 2), 4), 8), 16) + 1U)
+
+/* The storage in bytes needed by a fifo of capacity bytes. */
+#ifdef CONFIG_SIMPLE_FIFO_POWER_OF_TWO
+#define SIMPLE_FIFO_STORAGE_SIZE(capacity)          SIMPLE_FIFO_ROUND_UP_POWER_OF_TWO(capacity)
+#else
+#define SIMPLE_FIFO_STORAGE_SIZE(capacity)          ((uint32_t)(capacity) + 1U)
+#endif
+
+/**
+ * @brief Define a static object named name holding the control block and the storage
+ * of a fifo of capacity bytes. SIMPLE_FIFO_INIT(name) initializes it and returns the
+ * handle, no heap is used, so it can run before the heap is ready.
+ */
+#define SIMPLE_FIFO_DEFINE(name, capacity)                                      \
+    static struct {                                                             \
+        struct simple_fifo control;                                             \
+        uint8_t storage[SIMPLE_FIFO_STORAGE_SIZE(capacity)];                    \
+    } name
+#define SIMPLE_FIFO_INIT(name)                      \
+        simple_fifo_init(&(name).control, (name).storage, sizeof((name).storage))
+
 /*---------- type define ----------*/
 typedef struct simple_fifo *simple_fifo_t;
+/* The members are private, the definition is only public to place a fifo statically. */
+struct simple_fifo {
+    uint32_t capacity;
+    uint8_t *pbuf;
+    uint32_t head;
+    uint32_t tail;
+};
 
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /**
  * @brief Create a simple fifo instance, and return a handle by which the
  * created fifo can be referenced.
- * @param capacity Simple fifo will create a buffer with a size of capacity bytes.
+ * @param capacity Simple fifo will create a buffer with a size of capacity bytes. If
+ * CONFIG_SIMPLE_FIFO_POWER_OF_TWO is defined, the capacity is rounded up to a power of two.
  * 
  * @retval If the simple fifo is successfully created then a handle to the newly fifo
  * is returned. If the fifo cannot be created because there is insufficient heap remaining
@@ -50,6 +85,18 @@ typedef struct simple_fifo *simple_fifo_t;
  */
 extern simple_fifo_t simple_fifo_new(uint32_t capacity);
 
+/**
+ * @brief Initialize a fifo on caller-supplied storage without the heap, the fifo must not
+ * be deleted by simple_fifo_delete().
+ * @param self The control block of the fifo.
+ * @param storage The buffer of the fifo.
+ * @param size The size of storage in bytes, use SIMPLE_FIFO_STORAGE_SIZE(capacity) for
+ * a fifo of capacity bytes.
+ *
+ * @retval The handle of the fifo.
+ */
+extern simple_fifo_t simple_fifo_init(simple_fifo_t self, void *storage, uint32_t size);
+
 /**
  * @brief Delete a fifo that was previously created using the simple_fifo_new() API function.
  * @param self The handle of the fifo being deleted.
@@ -101,6 +148,48 @@ extern uint32_t simple_fifo_push(simple_fifo_t self, const uint8_t *pbuf, uint32
  */
 extern uint32_t simple_fifo_pop(simple_fifo_t self, uint8_t *pbuf, uint32_t capacity);
 
+/**
+ * @brief Get the contiguous free space of the fifo, so that the producer can write into
+ * the fifo directly, e.g. by DMA. When the free space wraps, the second span is returned
+ * by the next call after simple_fifo_write_commit().
+ * @param self The handle of the fifo.
+ * @param pptr The start of the free space.
+ * @param plength The contiguous free bytes, 0 if the fifo is full.
+ *
+ * @retval None
+ */
+extern void simple_fifo_write_reserve(simple_fifo_t self, uint8_t **pptr, uint32_t *plength);
+
+/**
+ * @brief Append the bytes written into the space from simple_fifo_write_reserve().
+ * @param self The handle of the fifo.
+ * @param length The bytes written, it must not exceed the reserved bytes.
+ *
+ * @retval None
+ */
+extern void simple_fifo_write_commit(simple_fifo_t self, uint32_t length);
+
+/**
+ * @brief Get the contiguous data of the fifo without copying, so that the consumer can
+ * parse it in place. When the data wraps, the second span is returned by the next call
+ * after simple_fifo_read_release().
+ * @param self The handle of the fifo.
+ * @param pptr The start of the data.
+ * @param plength The contiguous data bytes, 0 if the fifo is empty.
+ *
+ * @retval None
+ */
+extern void simple_fifo_read_peek(simple_fifo_t self, const uint8_t **pptr, uint32_t *plength);
+
+/**
+ * @brief Drop the bytes got from simple_fifo_read_peek().
+ * @param self The handle of the fifo.
+ * @param length The bytes consumed, it must not exceed the peeked bytes.
+ *
+ * @retval None
+ */
+extern void simple_fifo_read_release(simple_fifo_t self, uint32_t length);
+
 #ifdef __cplusplus
 }
 #endif
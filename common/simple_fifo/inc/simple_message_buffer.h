@@ -34,8 +34,33 @@ extern "C"
 #include <stddef.h>
 
 /*---------- macro ----------*/
+/**
+ * @brief Define a static object named name holding the control block and size bytes of
+ * storage of a message buffer. SIMPLE_MESSAGE_INIT(name) initializes it and returns the
+ * handle without the heap.
+ */
+#define SIMPLE_MESSAGE_DEFINE(name, size)                                       \
+    static struct {                                                             \
+        struct simple_message control;                                          \
+        uint8_t storage[size];                                                  \
+    } name
+#define SIMPLE_MESSAGE_INIT(name)                   \
+        simple_message_init(&(name).control, (name).storage, sizeof((name).storage))
+
 /*---------- type define ----------*/
+/* Messages are stored as contiguous records with a 16-bit length, so a message is
+ * at most 65534 bytes and never wraps around the end of the buffer.
+ */
 typedef struct simple_message *simple_message_t;
+/* The members are private, the definition is only public to place a message buffer
+ * statically. */
+struct simple_message {
+    uint32_t capacity;
+    uint8_t *pbuf;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t used;          /*<< Bytes of records and padding */
+};
 
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
@@ -51,6 +76,17 @@ typedef struct simple_message *simple_message_t;
  */
 extern simple_message_t simple_message_new(uint32_t size);
 
+/**
+ * @brief Initialize a message buffer on caller-supplied storage without the heap, it
+ * must not be deleted by simple_message_delete().
+ * @param self The control block of the message buffer.
+ * @param storage The buffer of the messages.
+ * @param size The size of storage in bytes.
+ *
+ * @retval The handle of the message buffer.
+ */
+extern simple_message_t simple_message_init(simple_message_t self, void *storage, uint32_t size);
+
 /**
  * @brief Delete a message that was previously created using the simple_message_new()
  * API function.
@@ -75,7 +111,8 @@ extern void simple_message_reset(simple_message_t self);
  * @param length The length of message content.
  * 
  * @retval If message was pushed successfully then true is returned.
- * If not, false is returned.
+ * If not, e.g. there is no contiguous space or the length exceeds 65534,
+ * false is returned.
  */
 extern bool simple_message_push(simple_message_t self, const void *member, uint32_t length);
 
@@ -90,6 +127,25 @@ extern bool simple_message_push(simple_message_t self, const void *member, uint3
  */
 extern bool simple_message_pop(simple_message_t self, void *member, uint32_t capacity);
 
+/**
+ * @brief Get the first message without copying, the content stays valid until
+ * it is dropped, popped or the message is reset.
+ * @param self The handle of message.
+ * @param pmember The pointer to the message content.
+ * @param plength The length of the message content.
+ *
+ * @retval If there is a message then true is returned. If not, false is returned.
+ */
+extern bool simple_message_peek(simple_message_t self, const void **pmember, uint32_t *plength);
+
+/**
+ * @brief Drop the first message without copying.
+ * @param self The handle of message.
+ *
+ * @retval If a message was dropped then true is returned. If not, false is returned.
+ */
+extern bool simple_message_drop(simple_message_t self);
+
 #ifdef __cplusplus
 }
 #endif
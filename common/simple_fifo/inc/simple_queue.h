@@ -32,10 +32,69 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "simple_fifo.h"
+#ifdef CONFIG_SIMPLE_QUEUE_MPMC
+#include <stdatomic.h>
+#endif
 
 /*---------- macro ----------*/
+#ifdef CONFIG_SIMPLE_QUEUE_MPMC
+/* Keeps the enqueue and dequeue positions in different cache lines on the host. */
+#ifndef CONFIG_SIMPLE_QUEUE_CACHE_LINE_SIZE
+#define CONFIG_SIMPLE_QUEUE_CACHE_LINE_SIZE         (0)
+#endif
+
+/* A slot is the member behind a 32-bit sequence, padded to keep the sequences aligned. */
+#define SIMPLE_QUEUE_SLOT_SIZE(member_size)         \
+        (((uint32_t)(member_size) + 2U * sizeof(uint32_t) - 1U) & ~(uint32_t)(sizeof(uint32_t) - 1U))
+/* The storage in bytes needed by a queue of member_count members of member_size bytes. */
+#define SIMPLE_QUEUE_STORAGE_SIZE(member_count, member_size)    \
+        (SIMPLE_FIFO_ROUND_UP_POWER_OF_TWO(member_count) * SIMPLE_QUEUE_SLOT_SIZE(member_size))
+#else
+#define SIMPLE_QUEUE_STORAGE_SIZE(member_count, member_size)    \
+        SIMPLE_FIFO_STORAGE_SIZE((uint32_t)(member_count) * (member_size))
+#endif
+
+/**
+ * @brief Define a static object named name holding the control block and the storage
+ * of a queue of count members of size bytes. SIMPLE_QUEUE_INIT(name) initializes it and returns the handle without
+ * the heap.
+ */
+#define SIMPLE_QUEUE_DEFINE(name, count, size)                                  \
+    static struct {                                                             \
+        struct simple_queue control;                                            \
+        uint32_t member_size;                                                   \
+        uint8_t storage[SIMPLE_QUEUE_STORAGE_SIZE(count, size)];                \
+    } name = { .member_size = (size) }
+#define SIMPLE_QUEUE_INIT(name)                     \
+        simple_queue_init(&(name).control, (name).storage, sizeof((name).storage), (name).member_size)
+
 /*---------- type define ----------*/
+/* Define CONFIG_SIMPLE_QUEUE_MPMC on the host to make push and pop safe for multiple
+ * producers and consumers without lock, member_count is rounded up to a power of two
+ * and simple_queue_reset() must not run concurrently with other calls. The option
+ * changes the control block, so it must be the same for every file including this one.
+ */
 typedef struct simple_queue *simple_queue_t;
+/* The members are private, the definition is only public to place a queue statically. */
+#ifdef CONFIG_SIMPLE_QUEUE_MPMC
+struct simple_queue {
+    uint32_t member_size;
+    uint32_t slot_size;
+    uint32_t mask;
+    uint8_t *pslots;
+    _Atomic uint32_t enqueue_pos;
+#if (CONFIG_SIMPLE_QUEUE_CACHE_LINE_SIZE > 0)
+    uint8_t padding[CONFIG_SIMPLE_QUEUE_CACHE_LINE_SIZE];
+#endif
+    _Atomic uint32_t dequeue_pos;
+};
+#else
+struct simple_queue {
+    struct simple_fifo fifo;
+    uint32_t member_size;
+};
+#endif
 
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
@@ -51,6 +110,19 @@ typedef struct simple_queue *simple_queue_t;
  */
 extern simple_queue_t simple_queue_new(uint32_t member_count, uint32_t member_size);
 
+/**
+ * @brief Initialize a queue on caller-supplied storage without the heap, the queue must
+ * not be deleted by simple_queue_delete().
+ * @param self The control block of the queue.
+ * @param storage The buffer of the queue, aligned to 4 bytes.
+ * @param size The size of storage in bytes, use SIMPLE_QUEUE_STORAGE_SIZE(member_count,
+ * member_size).
+ * @param member_size Size of queue member.
+ *
+ * @retval The handle of the queue.
+ */
+extern simple_queue_t simple_queue_init(simple_queue_t self, void *storage, uint32_t size, uint32_t member_size);
+
 /**
  * @brief Delete a queue that was previously created using the simple_queue_new() API
  * function.
@@ -88,6 +160,26 @@ extern bool simple_queue_push(simple_queue_t self, const void *member);
  */
 extern bool simple_queue_pop(simple_queue_t self, void *member);
 
+/**
+ * @brief Push up to count queue members stored back to back.
+ * @param self The handle of the queue being pushed.
+ * @param members The queue members.
+ * @param count Number of the queue members.
+ *
+ * @retval The number of members pushed, it is less than count if the queue is full.
+ */
+extern uint32_t simple_queue_push_batch(simple_queue_t self, const void *members, uint32_t count);
+
+/**
+ * @brief Pop up to count queue members and store them back to back.
+ * @param self The handle of the queue being poped.
+ * @param members The container for storing the members.
+ * @param count The capacity of the container in members.
+ *
+ * @retval The number of members poped, it is less than count if the queue is empty.
+ */
+extern uint32_t simple_queue_pop_batch(simple_queue_t self, void *members, uint32_t count);
+
 #ifdef __cplusplus
 }
 #endif
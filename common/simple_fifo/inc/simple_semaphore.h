@@ -32,6 +32,12 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#ifdef CONFIG_SIMPLE_SEMAPHORE_ATOMIC
+#include <stdatomic.h>
+#endif
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+#include <pthread.h>
+#endif
 
 /*---------- macro ----------*/
 /**
@@ -44,8 +50,51 @@ extern "C"
  */
 #define simple_semaphore_binary_new()               simple_semaphore_new(1)
 
+/* Timeout of simple_semaphore_wait() which never expires. */
+#define SIMPLE_SEMAPHORE_WAIT_FOREVER               (0xFFFFFFFFUL)
+
+/**
+ * @brief Define a static semaphore object named name with count members.
+ * SIMPLE_SEMAPHORE_INIT(name) initializes it and returns the handle without the heap.
+ */
+#define SIMPLE_SEMAPHORE_DEFINE(name, count)                                    \
+    static struct {                                                             \
+        struct simple_semaphore control;                                        \
+        uint32_t max_count;                                                     \
+    } name = { .max_count = (count) }
+#define SIMPLE_SEMAPHORE_INIT(name)                 \
+        simple_semaphore_init(&(name).control, (name).max_count)
+
+#if defined(CONFIG_SIMPLE_SEMAPHORE_WAIT) && !defined(CONFIG_SIMPLE_SEMAPHORE_ATOMIC)
+#error "CONFIG_SIMPLE_SEMAPHORE_WAIT requires CONFIG_SIMPLE_SEMAPHORE_ATOMIC"
+#endif
+
 /*---------- type define ----------*/
+/* A counter from 0 up to the count passed to simple_semaphore_new(), the
+ * semaphore is created empty. The counter is changed in __enter_critical(), define
+ * CONFIG_SIMPLE_SEMAPHORE_ATOMIC on a target with C11 lock-free atomics, e.g. the
+ * POSIX host, to change it with compare-and-swap instead.
+ * CONFIG_SIMPLE_SEMAPHORE_ATOMIC and CONFIG_SIMPLE_SEMAPHORE_WAIT change the control
+ * block, so they must be the same for every file including this one.
+ */
 typedef struct simple_semaphore *simple_semaphore_t;
+/* The members are private, the definition is only public to place a semaphore
+ * statically. push and pop only touch the counter, so both can be called from an
+ * ISR. The mutex and condition are used by simple_semaphore_wait() on the POSIX host.
+ */
+struct simple_semaphore {
+    uint32_t max_count;
+#ifdef CONFIG_SIMPLE_SEMAPHORE_ATOMIC
+    _Atomic uint32_t count;
+#else
+    uint32_t count;
+#endif
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+    _Atomic uint32_t waiters;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+#endif
+};
 
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
@@ -60,6 +109,17 @@ typedef struct simple_semaphore *simple_semaphore_t;
  */
 extern simple_semaphore_t simple_semaphore_new(uint32_t count);
 
+/**
+ * @brief Initialize a semaphore on a caller-supplied control block without the heap,
+ * it must not be deleted by simple_semaphore_delete().
+ * @param self The control block of the semaphore.
+ * @param count Number of semaphore member.
+ *
+ * @return The handle of the semaphore, or NULL if the mutex or condition of
+ * simple_semaphore_wait() cannot be created.
+ */
+extern simple_semaphore_t simple_semaphore_init(simple_semaphore_t self, uint32_t count);
+
 /**
  * @brief Delete a semaphore that was previously created using the simple_semaphore_new() API
  * function.
@@ -81,6 +141,7 @@ extern void simple_semaphore_reset(simple_semaphore_t self);
  * @brief Push a semaphore member to the semaphore.
  * @param self The handle of the semaphore being pushed.
  * 
+ * @note It does not block, so it is safe to call from an ISR.
  * @return If member was pushed successfully the true is returned.
  * If member was pushed failure then false is returned.
  */
@@ -90,11 +151,26 @@ extern bool simple_semaphore_push(simple_semaphore_t self);
  * @brief Pop a semaphore member from the semaphore.
  * @param self The handle of the semaphore being poped.
  * 
+ * @note It does not block, so it is safe to call from an ISR.
  * @return If member was poped successfully then true is returned.
  * If member was poped failure then false is returned.
  */
 extern bool simple_semaphore_pop(simple_semaphore_t self);
 
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+/**
+ * @brief Pop a semaphore member, block the calling thread until a member is pushed
+ * or the timeout expires. Only available on the POSIX host.
+ * @param self The handle of the semaphore being waited.
+ * @param timeout The time to wait in milliseconds, 0 does not block and
+ * SIMPLE_SEMAPHORE_WAIT_FOREVER never expires.
+ *
+ * @return If member was poped successfully then true is returned.
+ * If the timeout expired then false is returned.
+ */
+extern bool simple_semaphore_wait(simple_semaphore_t self, uint32_t timeout);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,145 @@
+/**
+ * @file common/simple_fifo/inc/simple_spsc_fifo.h
+ *
+ * Copyright (C) 2024
+ *
+ * simple_spsc_fifo.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+#ifndef __SIMPLE_SPSC_FIFO_H
+#define __SIMPLE_SPSC_FIFO_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*---------- macro ----------*/
+/*---------- type define ----------*/
+/* A single producer single consumer byte fifo without lock, e.g. an ISR producer and a
+ * thread consumer, or two host threads. The producer only calls push/write_*, the consumer
+ * only calls pop/read_*, the size queries can be called by both.
+ */
+typedef struct simple_spsc_fifo *simple_spsc_fifo_t;
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/**
+ * @brief Create a spsc fifo instance, and return a handle by which the created fifo
+ * can be referenced.
+ * @param capacity The size of the buffer in bytes, it is rounded up to a power of two.
+ *
+ * @retval If the fifo is successfully created then a handle to the newly fifo is returned.
+ * If the fifo cannot be created because there is insufficient heap remaining then NULL
+ * is returned.
+ */
+extern simple_spsc_fifo_t simple_spsc_fifo_new(uint32_t capacity);
+
+/**
+ * @brief Delete a fifo that was previously created using the simple_spsc_fifo_new() API
+ * function. Neither side may use the fifo any more.
+ * @param self The handle of the fifo being deleted.
+ *
+ * @retval None
+ */
+extern void simple_spsc_fifo_delete(simple_spsc_fifo_t self);
+
+/**
+ * @brief Query the bytes which can be pushed.
+ * @param self The handle of the fifo being queried.
+ *
+ * @retval The remaining size of the fifo.
+ */
+extern uint32_t simple_spsc_fifo_get_remaining_size(simple_spsc_fifo_t self);
+
+/**
+ * @brief Query the bytes which can be popped.
+ * @param self The handle of the fifo being queried.
+ *
+ * @retval The available size of the fifo.
+ */
+extern uint32_t simple_spsc_fifo_get_available_size(simple_spsc_fifo_t self);
+
+/**
+ * @brief Push serial bytes to the fifo, only called by the producer.
+ * @param self The handle of the fifo being pushed.
+ * @param pbuf Serial bytes.
+ * @param length The length of the bytes.
+ *
+ * @retval The bytes length which has been pushed is returned.
+ */
+extern uint32_t simple_spsc_fifo_push(simple_spsc_fifo_t self, const uint8_t *pbuf, uint32_t length);
+
+/**
+ * @brief Pop serial bytes from the fifo, only called by the consumer.
+ * @param self The handle of the fifo being popped.
+ * @param pbuf The container for storing serial bytes.
+ * @param capacity The size of the container.
+ *
+ * @retval The bytes length which has been popped is returned.
+ */
+extern uint32_t simple_spsc_fifo_pop(simple_spsc_fifo_t self, uint8_t *pbuf, uint32_t capacity);
+
+/**
+ * @brief Get the contiguous free space of the fifo, so that the producer can write, e.g.
+ * by DMA, into the fifo directly. The space becomes visible to the consumer after
+ * simple_spsc_fifo_write_commit(). When the free space wraps, the second part is returned
+ * by the next call after the commit.
+ * @param self The handle of the fifo.
+ * @param pptr The start of the free space.
+ *
+ * @retval The contiguous free bytes, 0 if the fifo is full.
+ */
+extern uint32_t simple_spsc_fifo_write_reserve(simple_spsc_fifo_t self, uint8_t **pptr);
+
+/**
+ * @brief Publish the bytes written into the space from simple_spsc_fifo_write_reserve().
+ * @param self The handle of the fifo.
+ * @param length The bytes written, it must not exceed the reserved bytes.
+ *
+ * @retval None
+ */
+extern void simple_spsc_fifo_write_commit(simple_spsc_fifo_t self, uint32_t length);
+
+/**
+ * @brief Get the contiguous data of the fifo without copying. The data stays in the fifo
+ * until simple_spsc_fifo_read_release().
+ * @param self The handle of the fifo.
+ * @param pptr The start of the data.
+ *
+ * @retval The contiguous data bytes, 0 if the fifo is empty.
+ */
+extern uint32_t simple_spsc_fifo_read_peek(simple_spsc_fifo_t self, const uint8_t **pptr);
+
+/**
+ * @brief Return the bytes got from simple_spsc_fifo_read_peek() to the producer.
+ * @param self The handle of the fifo.
+ * @param length The bytes consumed, it must not exceed the peeked bytes.
+ *
+ * @retval None
+ */
+extern void simple_spsc_fifo_read_release(simple_spsc_fifo_t self, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SIMPLE_SPSC_FIFO_H */
@@ -27,34 +27,110 @@
 #include <string.h>
 
 /*---------- macro ----------*/
-/*---------- type define ----------*/
-struct simple_fifo {
-    uint32_t capacity;
-    uint8_t *pbuf;
-    uint32_t head;
-    uint32_t tail;
-};
+/* Define CONFIG_SIMPLE_FIFO_POWER_OF_TWO to round the capacity up to a power of two,
+ * head and tail then run freely and are masked on access, so no slot is wasted and
+ * no division is needed on the cores without a hardware divider.
+ */
 
+/*---------- type define ----------*/
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
 /*---------- function ----------*/
+#ifdef CONFIG_SIMPLE_FIFO_POWER_OF_TWO
+static inline uint32_t _round_up_power_of_two(uint32_t x)
+{
+    x--;
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+
+    return x + 1;
+}
+
+static inline uint32_t _size(simple_fifo_t self)
+{
+    return self->capacity;
+}
+
+static inline uint32_t _used(simple_fifo_t self)
+{
+    return self->head - self->tail;
+}
+
+static inline uint32_t _index(simple_fifo_t self, uint32_t counter)
+{
+    return counter & (self->capacity - 1);
+}
+
+static inline uint32_t _advance(simple_fifo_t self, uint32_t counter, uint32_t n)
+{
+    (void)self;
+    return counter + n;
+}
+#else
+/* One slot is kept empty to tell a full fifo from an empty one. */
+static inline uint32_t _size(simple_fifo_t self)
+{
+    return self->capacity - 1;
+}
+
+static inline uint32_t _used(simple_fifo_t self)
+{
+    return (self->head >= self->tail) ? (self->head - self->tail) : (self->head + self->capacity - self->tail);
+}
+
+static inline uint32_t _index(simple_fifo_t self, uint32_t counter)
+{
+    (void)self;
+    return counter;
+}
+
+static inline uint32_t _advance(simple_fifo_t self, uint32_t counter, uint32_t n)
+{
+    counter += n;
+
+    return (counter >= self->capacity) ? (counter - self->capacity) : counter;
+}
+#endif
+
 simple_fifo_t simple_fifo_new(uint32_t capacity)
 {
     simple_fifo_t self = NULL;
-    uint32_t wanted_size = sizeof(*self) + capacity + 1;
 
     assert(capacity);
-    self = (simple_fifo_t)__malloc(wanted_size);
+#ifdef CONFIG_SIMPLE_FIFO_POWER_OF_TWO
+    assert(capacity <= 0x80000000UL);
+    capacity = _round_up_power_of_two(capacity);
+#else
+    capacity = capacity + 1;
+#endif
+    self = (simple_fifo_t)__malloc(sizeof(*self) + capacity);
     if(self) {
-        memset((void *)self, 0, wanted_size);
-        self->pbuf = (uint8_t *)self + sizeof(*self);
-        self->capacity = capacity + 1;
+        simple_fifo_init(self, (uint8_t *)self + sizeof(*self), capacity);
     }
 
     return self;
 }
 
+simple_fifo_t simple_fifo_init(simple_fifo_t self, void *storage, uint32_t size)
+{
+    assert(self);
+    assert(storage);
+#ifdef CONFIG_SIMPLE_FIFO_POWER_OF_TWO
+    assert(size && !(size & (size - 1)));
+#else
+    assert(size > 1);
+#endif
+    memset((void *)self, 0, sizeof(*self));
+    self->pbuf = (uint8_t *)storage;
+    self->capacity = size;
+
+    return self;
+}
+
 void simple_fifo_delete(simple_fifo_t self)
 {
     assert(self);
@@ -63,20 +139,16 @@ void simple_fifo_delete(simple_fifo_t self)
 
 uint32_t simple_fifo_get_remaining_size(simple_fifo_t self)
 {
-    uint32_t full_tail = 0, available = 0;
-
     assert(self);
-    full_tail = (self->tail + self->capacity - 1) % self->capacity;
-    available = (full_tail + self->capacity - self->head) % self->capacity;
 
-    return available;
+    return _size(self) - _used(self);
 }
 
 uint32_t simple_fifo_get_available_size(simple_fifo_t self)
 {
     assert(self);
 
-    return ((self->head + self->capacity - self->tail) % self->capacity);
+    return _used(self);
 }
 
 void simple_fifo_reset(simple_fifo_t self)
@@ -88,29 +160,77 @@ void simple_fifo_reset(simple_fifo_t self)
 
 uint32_t simple_fifo_push(simple_fifo_t self, const uint8_t *pbuf, uint32_t length)
 {
-    uint32_t full_tail = 0, len = 0;
+    uint32_t len = 0, offset = 0, first = 0;
 
     assert(self);
     assert(pbuf);
-    full_tail = (self->tail + self->capacity - 1) % self->capacity;
-    while(self->head != full_tail && len < length) {
-        self->pbuf[self->head] = pbuf[len++];
-        self->head = (self->head + 1) % self->capacity;
-    }
+    len = _size(self) - _used(self);
+    len = (length < len) ? length : len;
+    /* the data wraps at most once, so it is copied in two segments */
+    offset = _index(self, self->head);
+    first = self->capacity - offset;
+    first = (len < first) ? len : first;
+    memcpy(self->pbuf + offset, pbuf, first);
+    memcpy(self->pbuf, pbuf + first, len - first);
+    self->head = _advance(self, self->head, len);
 
     return len;
 }
 
 uint32_t simple_fifo_pop(simple_fifo_t self, uint8_t *pbuf, uint32_t capacity)
 {
-    uint32_t len = 0;
+    uint32_t len = 0, offset = 0, first = 0;
 
     assert(self);
     assert(pbuf);
-    while(self->head != self->tail && len < capacity) {
-        pbuf[len++] = self->pbuf[self->tail];
-        self->tail = (self->tail + 1) % self->capacity;
-    }
+    len = _used(self);
+    len = (capacity < len) ? capacity : len;
+    offset = _index(self, self->tail);
+    first = self->capacity - offset;
+    first = (len < first) ? len : first;
+    memcpy(pbuf, self->pbuf + offset, first);
+    memcpy(pbuf + first, self->pbuf, len - first);
+    self->tail = _advance(self, self->tail, len);
 
     return len;
 }
+
+void simple_fifo_write_reserve(simple_fifo_t self, uint8_t **pptr, uint32_t *plength)
+{
+    uint32_t len = 0, offset = 0;
+
+    assert(self);
+    assert(pptr);
+    assert(plength);
+    len = _size(self) - _used(self);
+    offset = _index(self, self->head);
+    *pptr = self->pbuf + offset;
+    *plength = ((self->capacity - offset) < len) ? (self->capacity - offset) : len;
+}
+
+void simple_fifo_write_commit(simple_fifo_t self, uint32_t length)
+{
+    assert(self);
+    assert(length <= (_size(self) - _used(self)));
+    self->head = _advance(self, self->head, length);
+}
+
+void simple_fifo_read_peek(simple_fifo_t self, const uint8_t **pptr, uint32_t *plength)
+{
+    uint32_t len = 0, offset = 0;
+
+    assert(self);
+    assert(pptr);
+    assert(plength);
+    len = _used(self);
+    offset = _index(self, self->tail);
+    *pptr = self->pbuf + offset;
+    *plength = ((self->capacity - offset) < len) ? (self->capacity - offset) : len;
+}
+
+void simple_fifo_read_release(simple_fifo_t self, uint32_t length)
+{
+    assert(self);
+    assert(length <= _used(self));
+    self->tail = _advance(self, self->tail, length);
+}
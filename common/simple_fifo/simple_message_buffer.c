@@ -23,40 +23,90 @@
 
 /*---------- includes ----------*/
 #include "simple_message_buffer.h"
-#include "simple_fifo.h"
 #include "options.h"
 #include <string.h>
 
 /*---------- macro ----------*/
+#define SIMPLE_MESSAGE_HEADER_SIZE      (sizeof(uint16_t))
+/* A header with this length marks the unused tail of the buffer, the next
+ * record starts at offset 0. */
+#define SIMPLE_MESSAGE_PADDING          (0xFFFFU)
+
 /*---------- type define ----------*/
-struct simple_message {
-    simple_fifo_t fifo;
-    uint32_t capacity;
-};
+/* Every record is a 16-bit length followed by the content. A record never wraps,
+ * so it can be peeked in place and dropped by moving the tail once.
+ */
 
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
 /*---------- function ----------*/
+static inline uint16_t _read_header(simple_message_t self, uint32_t offset)
+{
+    uint16_t length = 0;
+
+    memcpy(&length, self->pbuf + offset, sizeof(length));
+
+    return length;
+}
+
+static inline void _write_header(simple_message_t self, uint32_t offset, uint16_t length)
+{
+    memcpy(self->pbuf + offset, &length, sizeof(length));
+}
+
+/* Skip the padding in front of the first record, the first record length is
+ * returned, or SIMPLE_MESSAGE_PADDING if there is no record. */
+static uint16_t _front(simple_message_t self)
+{
+    uint16_t length = SIMPLE_MESSAGE_PADDING;
+
+    if(self->used) {
+        if((self->capacity - self->tail) < SIMPLE_MESSAGE_HEADER_SIZE ||
+           SIMPLE_MESSAGE_PADDING == _read_header(self, self->tail)) {
+            self->used -= self->capacity - self->tail;
+            self->tail = 0;
+        }
+        length = _read_header(self, self->tail);
+    }
+
+    return length;
+}
+
+static void _drop_front(simple_message_t self, uint16_t length)
+{
+    self->tail += SIMPLE_MESSAGE_HEADER_SIZE + length;
+    self->used -= SIMPLE_MESSAGE_HEADER_SIZE + length;
+    if(0 == self->used) {
+        /* start over to get the largest contiguous space */
+        self->head = 0;
+        self->tail = 0;
+    } else if(self->tail == self->capacity) {
+        self->tail = 0;
+    }
+}
+
 simple_message_t simple_message_new(uint32_t size)
 {
     simple_message_t self = NULL;
 
     assert(size);
-    do {
-        self = __malloc(sizeof(*self));
-        if(!self) {
-            break;
-        }
-        memset((void *)self, 0, sizeof(*self));
-        self->fifo = simple_fifo_new(size);
-        if(!self->fifo) {
-            __free(self);
-            self = NULL;
-            break;
-        }
-        self->capacity = size;
-    } while(0);
+    self = __malloc(sizeof(*self) + size);
+    if(self) {
+        simple_message_init(self, (uint8_t *)self + sizeof(*self), size);
+    }
+
+    return self;
+}
+
+simple_message_t simple_message_init(simple_message_t self, void *storage, uint32_t size)
+{
+    assert(self);
+    assert(storage);
+    assert(size);
+    memset((void *)self, 0, sizeof(*self));
+    self->pbuf = (uint8_t *)storage;
+    self->capacity = size;
 
     return self;
 }
@@ -64,63 +114,108 @@ simple_message_t simple_message_new(uint32_t size)
 void simple_message_delete(simple_message_t self)
 {
     assert(self);
-    simple_fifo_delete(self->fifo);
     __free(self);
 }
 
 void simple_message_reset(simple_message_t self)
 {
     assert(self);
-    simple_fifo_reset(self->fifo);
+    self->head = 0;
+    self->tail = 0;
+    self->used = 0;
 }
 
 bool simple_message_push(simple_message_t self, const void *member, uint32_t length)
 {
     bool retval = false;
-    uint32_t remaining_size = 0;
+    uint32_t need = SIMPLE_MESSAGE_HEADER_SIZE + length, offset = 0;
 
     assert(self);
     assert(member);
-    remaining_size = simple_fifo_get_remaining_size(self->fifo);
-    if(remaining_size >= (length + sizeof(length))) {
-        simple_fifo_push(self->fifo, (const uint8_t *)&length, sizeof(length));
-        simple_fifo_push(self->fifo, (const uint8_t *)member, length);
+    offset = self->head;
+    do {
+        if(length >= SIMPLE_MESSAGE_PADDING) {
+            break;
+        }
+        if(self->used && self->head <= self->tail) {
+            /* the free space is between head and tail */
+            if(self->head == self->tail || need > (self->tail - self->head)) {
+                break;
+            }
+        } else if(need > (self->capacity - self->head)) {
+            /* the free space is split, the record is placed at the beginning and
+             * the tail of the buffer is padded */
+            if(need > self->tail) {
+                break;
+            }
+            if((self->capacity - self->head) >= SIMPLE_MESSAGE_HEADER_SIZE) {
+                _write_header(self, self->head, SIMPLE_MESSAGE_PADDING);
+            }
+            self->used += self->capacity - self->head;
+            offset = 0;
+        }
+        _write_header(self, offset, (uint16_t)length);
+        memcpy(self->pbuf + offset + SIMPLE_MESSAGE_HEADER_SIZE, member, length);
+        self->used += need;
+        self->head = offset + need;
+        if(self->head == self->capacity) {
+            self->head = 0;
+        }
         retval = true;
+    } while(0);
+
+    return retval;
+}
+
+bool simple_message_pop(simple_message_t self, void *member, uint32_t capacity)
+{
+    bool retval = false;
+    uint16_t length = 0;
+
+    assert(self);
+    assert(member);
+    length = _front(self);
+    if(SIMPLE_MESSAGE_PADDING != length) {
+        /* a message larger than the container is dropped */
+        if(length <= capacity) {
+            memcpy(member, self->pbuf + self->tail + SIMPLE_MESSAGE_HEADER_SIZE, length);
+            retval = true;
+        }
+        _drop_front(self, length);
     }
 
     return retval;
 }
 
-static void _drop_message(simple_message_t self, uint32_t drop_length)
+bool simple_message_peek(simple_message_t self, const void **pmember, uint32_t *plength)
 {
-    uint8_t drop_byte = 0;
+    bool retval = false;
+    uint16_t length = 0;
 
-    for(uint32_t i = 0; i < drop_length; ++i) {
-        simple_fifo_pop(self->fifo, &drop_byte, sizeof(drop_byte));
+    assert(self);
+    assert(pmember);
+    assert(plength);
+    length = _front(self);
+    if(SIMPLE_MESSAGE_PADDING != length) {
+        *pmember = self->pbuf + self->tail + SIMPLE_MESSAGE_HEADER_SIZE;
+        *plength = length;
+        retval = true;
     }
+
+    return retval;
 }
 
-bool simple_message_pop(simple_message_t self, void *member, uint32_t capacity)
+bool simple_message_drop(simple_message_t self)
 {
     bool retval = false;
-    uint32_t available_size = 0;
-    uint32_t length = 0;
+    uint16_t length = 0;
 
     assert(self);
-    assert(member);
-    do {
-        available_size = simple_fifo_get_available_size(self->fifo);
-        if(available_size <= 4) {
-            break;
-        }
-        simple_fifo_pop(self->fifo, (uint8_t *)&length, sizeof(length));
-        if(length > capacity) {
-            _drop_message(self, length);
-            break;
-        }
-        simple_fifo_pop(self->fifo, (uint8_t *)member, length);
+    length = _front(self);
+    if(SIMPLE_MESSAGE_PADDING != length) {
+        _drop_front(self, length);
         retval = true;
-    } while(0);
+    }
 
     return retval;
 }
@@ -23,45 +23,192 @@
 
 /*---------- includes ----------*/
 #include "simple_queue.h"
-#include "simple_fifo.h"
 #include "options.h"
 #include <string.h>
 
 /*---------- macro ----------*/
 /*---------- type define ----------*/
-struct simple_queue {
-    simple_fifo_t fifo;
-    uint32_t member_size;
-    uint32_t member_count;
+#ifdef CONFIG_SIMPLE_QUEUE_MPMC
+/* Bounded multi-producer multi-consumer queue by Dmitry Vyukov. Every slot carries a
+ * sequence number: it equals the position when the slot is free for that position's
+ * producer, and position + 1 when it holds the member for that position's consumer.
+ */
+struct slot {
+    _Atomic uint32_t sequence;
 };
+#endif
 
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
 /*---------- function ----------*/
+#ifdef CONFIG_SIMPLE_QUEUE_MPMC
+static inline struct slot *_slot(simple_queue_t self, uint32_t pos)
+{
+    return (struct slot *)(self->pslots + (pos & self->mask) * self->slot_size);
+}
+
+static inline uint8_t *_slot_data(struct slot *pslot)
+{
+    return (uint8_t *)pslot + sizeof(*pslot);
+}
+
+/* Claim up to count consecutive positions whose slots are ready, ready means the
+ * sequence equals the position plus offset. The number of claimed positions is
+ * returned and the first one is stored in ppos.
+ */
+static uint32_t _claim(simple_queue_t self, _Atomic uint32_t *pposition, uint32_t offset,
+                       uint32_t count, uint32_t *ppos)
+{
+    uint32_t pos = atomic_load_explicit(pposition, memory_order_relaxed);
+    uint32_t n = 0, sequence = 0;
+
+    for(;;) {
+        for(n = 0; n < count; ++n) {
+            sequence = atomic_load_explicit(&_slot(self, pos + n)->sequence, memory_order_acquire);
+            if(sequence != pos + n + offset) {
+                break;
+            }
+        }
+        if(0 == n && (int32_t)(sequence - (pos + offset)) > 0) {
+            /* another side has taken the position, try the new one */
+            pos = atomic_load_explicit(pposition, memory_order_relaxed);
+            continue;
+        }
+        /* full or empty if nothing is ready, on failure pos is reloaded */
+        if(0 == n || atomic_compare_exchange_weak_explicit(pposition, &pos, pos + n,
+                                                           memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+    }
+    *ppos = pos;
+
+    return n;
+}
+
 simple_queue_t simple_queue_new(uint32_t member_count, uint32_t member_size)
 {
     simple_queue_t self = NULL;
-    uint32_t wanted_size = sizeof(*self);
+    uint32_t wanted_size = 0;
 
     assert(member_count);
     assert(member_size);
-    do {
-        self = __malloc(wanted_size);
-        if(!self) {
-            break;
-        }
-        memset((void *)self, 0, wanted_size);
-        wanted_size = member_count * member_size;
-        self->fifo = simple_fifo_new(wanted_size);
-        if(!self->fifo) {
-            __free(self);
-            self = NULL;
-            break;
-        }
-        self->member_count = member_count;
-        self->member_size = member_size;
-    } while(0);
+    assert(member_count <= 0x80000000UL);
+    wanted_size = SIMPLE_QUEUE_STORAGE_SIZE(member_count, member_size);
+    self = __malloc(sizeof(*self) + wanted_size);
+    if(self) {
+        simple_queue_init(self, (uint8_t *)self + sizeof(*self), wanted_size, member_size);
+    }
+
+    return self;
+}
+
+simple_queue_t simple_queue_init(simple_queue_t self, void *storage, uint32_t size, uint32_t member_size)
+{
+    uint32_t slot_count = 0;
+
+    assert(self);
+    assert(storage);
+    assert(member_size);
+    assert(!((uintptr_t)storage & (sizeof(struct slot) - 1)));
+    memset((void *)self, 0, sizeof(*self));
+    self->member_size = member_size;
+    self->slot_size = SIMPLE_QUEUE_SLOT_SIZE(member_size);
+    slot_count = size / self->slot_size;
+    assert(slot_count && !(slot_count & (slot_count - 1)));
+    self->mask = slot_count - 1;
+    self->pslots = (uint8_t *)storage;
+    simple_queue_reset(self);
+
+    return self;
+}
+
+void simple_queue_delete(simple_queue_t self)
+{
+    assert(self);
+    __free(self);
+}
+
+void simple_queue_reset(simple_queue_t self)
+{
+    assert(self);
+    for(uint32_t i = 0; i <= self->mask; ++i) {
+        atomic_init(&_slot(self, i)->sequence, i);
+    }
+    atomic_init(&self->enqueue_pos, 0);
+    atomic_init(&self->dequeue_pos, 0);
+}
+
+uint32_t simple_queue_push_batch(simple_queue_t self, const void *members, uint32_t count)
+{
+    const uint8_t *p = (const uint8_t *)members;
+    struct slot *pslot = NULL;
+    uint32_t pos = 0, n = 0;
+
+    assert(self);
+    assert(members);
+    n = _claim(self, &self->enqueue_pos, 0, count, &pos);
+    for(uint32_t i = 0; i < n; ++i, p += self->member_size) {
+        pslot = _slot(self, pos + i);
+        memcpy(_slot_data(pslot), p, self->member_size);
+        atomic_store_explicit(&pslot->sequence, pos + i + 1, memory_order_release);
+    }
+
+    return n;
+}
+
+uint32_t simple_queue_pop_batch(simple_queue_t self, void *members, uint32_t count)
+{
+    uint8_t *p = (uint8_t *)members;
+    struct slot *pslot = NULL;
+    uint32_t pos = 0, n = 0;
+
+    assert(self);
+    assert(members);
+    n = _claim(self, &self->dequeue_pos, 1, count, &pos);
+    for(uint32_t i = 0; i < n; ++i, p += self->member_size) {
+        pslot = _slot(self, pos + i);
+        memcpy(p, _slot_data(pslot), self->member_size);
+        atomic_store_explicit(&pslot->sequence, pos + i + self->mask + 1, memory_order_release);
+    }
+
+    return n;
+}
+
+bool simple_queue_push(simple_queue_t self, const void *member)
+{
+    return (1 == simple_queue_push_batch(self, member, 1));
+}
+
+bool simple_queue_pop(simple_queue_t self, void *member)
+{
+    return (1 == simple_queue_pop_batch(self, member, 1));
+}
+#else
+simple_queue_t simple_queue_new(uint32_t member_count, uint32_t member_size)
+{
+    simple_queue_t self = NULL;
+    uint32_t wanted_size = 0;
+
+    assert(member_count);
+    assert(member_size);
+    wanted_size = SIMPLE_QUEUE_STORAGE_SIZE(member_count, member_size);
+    self = __malloc(sizeof(*self) + wanted_size);
+    if(self) {
+        simple_queue_init(self, (uint8_t *)self + sizeof(*self), wanted_size, member_size);
+    }
+
+    return self;
+}
+
+simple_queue_t simple_queue_init(simple_queue_t self, void *storage, uint32_t size, uint32_t member_size)
+{
+    assert(self);
+    assert(storage);
+    assert(member_size);
+    memset((void *)self, 0, sizeof(*self));
+    simple_fifo_init(&self->fifo, storage, size);
+    self->member_size = member_size;
 
     return self;
 }
@@ -69,14 +216,13 @@ simple_queue_t simple_queue_new(uint32_t member_count, uint32_t member_size)
 void simple_queue_delete(simple_queue_t self)
 {
     assert(self);
-    simple_fifo_delete(self->fifo);
     __free(self);
 }
 
 void simple_queue_reset(simple_queue_t self)
 {
     assert(self);
-    simple_fifo_reset(self->fifo);
+    simple_fifo_reset(&self->fifo);
 }
 
 bool simple_queue_push(simple_queue_t self, const void *member)
@@ -85,8 +231,8 @@ bool simple_queue_push(simple_queue_t self, const void *member)
 
     assert(self);
     assert(member);
-    if(simple_fifo_get_remaining_size(self->fifo) >= self->member_size) {
-        simple_fifo_push(self->fifo, (const uint8_t *)member, self->member_size);
+    if(simple_fifo_get_remaining_size(&self->fifo) >= self->member_size) {
+        simple_fifo_push(&self->fifo, (const uint8_t *)member, self->member_size);
         retval = true;
     }
 
@@ -99,10 +245,37 @@ bool simple_queue_pop(simple_queue_t self, void *member)
 
     assert(self);
     assert(member);
-    if(simple_fifo_get_available_size(self->fifo) >= self->member_size) {
-        simple_fifo_pop(self->fifo, member, self->member_size);
+    if(simple_fifo_get_available_size(&self->fifo) >= self->member_size) {
+        simple_fifo_pop(&self->fifo, member, self->member_size);
         retval = true;
     }
 
     return retval;
 }
+
+uint32_t simple_queue_push_batch(simple_queue_t self, const void *members, uint32_t count)
+{
+    uint32_t n = 0;
+
+    assert(self);
+    assert(members);
+    n = simple_fifo_get_remaining_size(&self->fifo) / self->member_size;
+    n = (count < n) ? count : n;
+    simple_fifo_push(&self->fifo, (const uint8_t *)members, n * self->member_size);
+
+    return n;
+}
+
+uint32_t simple_queue_pop_batch(simple_queue_t self, void *members, uint32_t count)
+{
+    uint32_t n = 0;
+
+    assert(self);
+    assert(members);
+    n = simple_fifo_get_available_size(&self->fifo) / self->member_size;
+    n = (count < n) ? count : n;
+    simple_fifo_pop(&self->fifo, (uint8_t *)members, n * self->member_size);
+
+    return n;
+}
+#endif
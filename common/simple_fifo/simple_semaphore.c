@@ -23,17 +23,15 @@
 
 /*---------- includes ----------*/
 #include "simple_semaphore.h"
-#include "simple_fifo.h"
 #include "options.h"
 #include <string.h>
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+#include <time.h>
+#include <errno.h>
+#endif
 
 /*---------- macro ----------*/
 /*---------- type define ----------*/
-struct simple_semaphore {
-    simple_fifo_t fifo;
-    uint32_t member_size;
-};
-
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /*---------- variable ----------*/
@@ -41,23 +39,48 @@ struct simple_semaphore {
 simple_semaphore_t simple_semaphore_new(uint32_t count)
 {
     simple_semaphore_t self = NULL;
-    uint32_t wanted_size = sizeof(*self);
 
+    assert(count);
+    self = __malloc(sizeof(*self));
+    if(self && !simple_semaphore_init(self, count)) {
+        __free(self);
+        self = NULL;
+    }
+
+    return self;
+}
+
+simple_semaphore_t simple_semaphore_init(simple_semaphore_t self, uint32_t count)
+{
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+    pthread_condattr_t attr;
+#endif
+
+    assert(self);
     assert(count);
     do {
-        self = __malloc(wanted_size);
-        if(!self) {
+        memset((void *)self, 0, sizeof(*self));
+        self->max_count = count;
+#ifdef CONFIG_SIMPLE_SEMAPHORE_ATOMIC
+        atomic_init(&self->count, 0);
+#endif
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+        atomic_init(&self->waiters, 0);
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        if(pthread_mutex_init(&self->mutex, NULL) != 0) {
+            pthread_condattr_destroy(&attr);
+            self = NULL;
             break;
         }
-        memset((void *)self, 0, wanted_size);
-        wanted_size = sizeof(uint32_t) * count;
-        self->fifo = simple_fifo_new(wanted_size);
-        if(!self->fifo) {
-            __free(self);
+        if(pthread_cond_init(&self->cond, &attr) != 0) {
+            pthread_condattr_destroy(&attr);
+            pthread_mutex_destroy(&self->mutex);
             self = NULL;
             break;
         }
-        self->member_size = sizeof(uint32_t);
+        pthread_condattr_destroy(&attr);
+#endif
     } while(0);
 
     return self;
@@ -66,27 +89,86 @@ simple_semaphore_t simple_semaphore_new(uint32_t count)
 void simple_semaphore_delete(simple_semaphore_t self)
 {
     assert(self);
-    simple_fifo_delete(self->fifo);
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+    pthread_cond_destroy(&self->cond);
+    pthread_mutex_destroy(&self->mutex);
+#endif
     __free(self);
 }
 
+#ifdef CONFIG_SIMPLE_SEMAPHORE_ATOMIC
+void simple_semaphore_reset(simple_semaphore_t self)
+{
+    assert(self);
+    atomic_store(&self->count, 0);
+}
+
+bool simple_semaphore_push(simple_semaphore_t self)
+{
+    bool err = false;
+    uint32_t count = 0;
+
+    assert(self);
+    count = atomic_load_explicit(&self->count, memory_order_relaxed);
+    while(count < self->max_count) {
+        if(atomic_compare_exchange_weak(&self->count, &count, count + 1)) {
+            err = true;
+            break;
+        }
+    }
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+    /* Store-load on both sides: the waiter increases waiters, fences and reads the
+     * counter, the pusher increases the counter, fences and reads waiters. The two
+     * seq_cst fences are totally ordered, so at least one side sees the other one
+     * and a waiter can not sleep on a counter it missed. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if(err && atomic_load_explicit(&self->waiters, memory_order_relaxed)) {
+        pthread_mutex_lock(&self->mutex);
+        pthread_cond_signal(&self->cond);
+        pthread_mutex_unlock(&self->mutex);
+    }
+#endif
+
+    return err;
+}
+
+bool simple_semaphore_pop(simple_semaphore_t self)
+{
+    bool err = false;
+    uint32_t count = 0;
+
+    assert(self);
+    count = atomic_load_explicit(&self->count, memory_order_relaxed);
+    while(count) {
+        if(atomic_compare_exchange_weak_explicit(&self->count, &count, count - 1,
+                                                 memory_order_acquire, memory_order_relaxed)) {
+            err = true;
+            break;
+        }
+    }
+
+    return err;
+}
+#else
 void simple_semaphore_reset(simple_semaphore_t self)
 {
     assert(self);
-    simple_fifo_reset(self->fifo);
+    __enter_critical();
+    self->count = 0;
+    __exit_critical();
 }
 
 bool simple_semaphore_push(simple_semaphore_t self)
 {
     bool err = false;
-    uint32_t val = 0;
 
-    (void)val;
     assert(self);
-    if(simple_fifo_get_remaining_size(self->fifo) >= self->member_size) {
-        simple_fifo_push(self->fifo, (const uint8_t *)&val, self->member_size);
+    __enter_critical();
+    if(self->count < self->max_count) {
+        self->count++;
         err = true;
     }
+    __exit_critical();
 
     return err;
 }
@@ -94,14 +176,57 @@ bool simple_semaphore_push(simple_semaphore_t self)
 bool simple_semaphore_pop(simple_semaphore_t self)
 {
     bool err = false;
-    uint32_t val = 0;
 
-    (void)val;
     assert(self);
-    if(simple_fifo_get_available_size(self->fifo) >= self->member_size) {
-        simple_fifo_pop(self->fifo, (void *)&val, self->member_size);
+    __enter_critical();
+    if(self->count) {
+        self->count--;
         err = true;
     }
+    __exit_critical();
+
+    return err;
+}
+#endif
+
+#ifdef CONFIG_SIMPLE_SEMAPHORE_WAIT
+bool simple_semaphore_wait(simple_semaphore_t self, uint32_t timeout)
+{
+    bool err = false;
+    struct timespec deadline = {0};
+
+    assert(self);
+    do {
+        err = simple_semaphore_pop(self);
+        if(err || !timeout) {
+            break;
+        }
+        if(SIMPLE_SEMAPHORE_WAIT_FOREVER != timeout) {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += timeout / 1000;
+            deadline.tv_nsec += (long)(timeout % 1000) * 1000000L;
+            if(deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+        }
+        pthread_mutex_lock(&self->mutex);
+        atomic_fetch_add(&self->waiters, 1);
+        /* Pairs with the fence in simple_semaphore_push(), the relaxed load of the
+         * counter in simple_semaphore_pop() can not move before the increase. */
+        atomic_thread_fence(memory_order_seq_cst);
+        while(!(err = simple_semaphore_pop(self))) {
+            if(SIMPLE_SEMAPHORE_WAIT_FOREVER == timeout) {
+                pthread_cond_wait(&self->cond, &self->mutex);
+            } else if(ETIMEDOUT == pthread_cond_timedwait(&self->cond, &self->mutex, &deadline)) {
+                err = simple_semaphore_pop(self);
+                break;
+            }
+        }
+        atomic_fetch_sub(&self->waiters, 1);
+        pthread_mutex_unlock(&self->mutex);
+    } while(0);
 
     return err;
 }
+#endif
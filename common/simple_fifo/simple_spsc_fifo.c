@@ -0,0 +1,200 @@
+/**
+ * @file common/simple_fifo/simple_spsc_fifo.c
+ *
+ * Copyright (C) 2024
+ *
+ * simple_spsc_fifo.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "simple_spsc_fifo.h"
+#include "options.h"
+#include <string.h>
+#include <stdatomic.h>
+
+/*---------- macro ----------*/
+/* Keeps head and tail in different cache lines on the host, 0 on the single core parts. */
+#ifndef CONFIG_SIMPLE_SPSC_FIFO_CACHE_LINE_SIZE
+#define CONFIG_SIMPLE_SPSC_FIFO_CACHE_LINE_SIZE     (0)
+#endif
+
+/*---------- type define ----------*/
+/* head and tail run freely, each of them is written by one side only. The side
+ * publishing data or space uses a release store, the other side reads it with
+ * an acquire load, so the bytes are visible before the index which covers them.
+ */
+struct simple_spsc_fifo {
+    uint32_t capacity;
+    uint8_t *pbuf;
+    _Atomic uint32_t head;      /*<< written by the producer */
+#if (CONFIG_SIMPLE_SPSC_FIFO_CACHE_LINE_SIZE > 0)
+    uint8_t padding[CONFIG_SIMPLE_SPSC_FIFO_CACHE_LINE_SIZE];
+#endif
+    _Atomic uint32_t tail;      /*<< written by the consumer */
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+/*---------- function ----------*/
+static inline uint32_t _round_up_power_of_two(uint32_t x)
+{
+    x--;
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    x |= x >> 16;
+
+    return x + 1;
+}
+
+/* Called by either side, the index of the other side may move between the two
+ * loads, so the result is clamped to the capacity. */
+static inline uint32_t _used(simple_spsc_fifo_t self)
+{
+    uint32_t tail = atomic_load_explicit(&self->tail, memory_order_acquire);
+    uint32_t used = atomic_load_explicit(&self->head, memory_order_acquire) - tail;
+
+    return (used > self->capacity) ? self->capacity : used;
+}
+
+simple_spsc_fifo_t simple_spsc_fifo_new(uint32_t capacity)
+{
+    simple_spsc_fifo_t self = NULL;
+    uint32_t wanted_size = 0;
+
+    assert(capacity);
+    assert(capacity <= 0x80000000UL);
+    capacity = _round_up_power_of_two(capacity);
+    wanted_size = sizeof(*self) + capacity;
+    self = (simple_spsc_fifo_t)__malloc(wanted_size);
+    if(self) {
+        memset((void *)self, 0, sizeof(*self));
+        self->pbuf = (uint8_t *)self + sizeof(*self);
+        self->capacity = capacity;
+        atomic_init(&self->head, 0);
+        atomic_init(&self->tail, 0);
+    }
+
+    return self;
+}
+
+void simple_spsc_fifo_delete(simple_spsc_fifo_t self)
+{
+    assert(self);
+    __free(self);
+}
+
+uint32_t simple_spsc_fifo_get_remaining_size(simple_spsc_fifo_t self)
+{
+    assert(self);
+
+    return self->capacity - _used(self);
+}
+
+uint32_t simple_spsc_fifo_get_available_size(simple_spsc_fifo_t self)
+{
+    assert(self);
+
+    return _used(self);
+}
+
+uint32_t simple_spsc_fifo_push(simple_spsc_fifo_t self, const uint8_t *pbuf, uint32_t length)
+{
+    uint32_t head = 0, len = 0, offset = 0, first = 0;
+
+    assert(self);
+    assert(pbuf);
+    head = atomic_load_explicit(&self->head, memory_order_relaxed);
+    len = self->capacity - (head - atomic_load_explicit(&self->tail, memory_order_acquire));
+    len = (length < len) ? length : len;
+    offset = head & (self->capacity - 1);
+    first = self->capacity - offset;
+    first = (len < first) ? len : first;
+    memcpy(self->pbuf + offset, pbuf, first);
+    memcpy(self->pbuf, pbuf + first, len - first);
+    atomic_store_explicit(&self->head, head + len, memory_order_release);
+
+    return len;
+}
+
+uint32_t simple_spsc_fifo_pop(simple_spsc_fifo_t self, uint8_t *pbuf, uint32_t capacity)
+{
+    uint32_t tail = 0, len = 0, offset = 0, first = 0;
+
+    assert(self);
+    assert(pbuf);
+    tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    len = atomic_load_explicit(&self->head, memory_order_acquire) - tail;
+    len = (capacity < len) ? capacity : len;
+    offset = tail & (self->capacity - 1);
+    first = self->capacity - offset;
+    first = (len < first) ? len : first;
+    memcpy(pbuf, self->pbuf + offset, first);
+    memcpy(pbuf + first, self->pbuf, len - first);
+    atomic_store_explicit(&self->tail, tail + len, memory_order_release);
+
+    return len;
+}
+
+uint32_t simple_spsc_fifo_write_reserve(simple_spsc_fifo_t self, uint8_t **pptr)
+{
+    uint32_t head = 0, len = 0, offset = 0;
+
+    assert(self);
+    assert(pptr);
+    head = atomic_load_explicit(&self->head, memory_order_relaxed);
+    len = self->capacity - (head - atomic_load_explicit(&self->tail, memory_order_acquire));
+    offset = head & (self->capacity - 1);
+    *pptr = self->pbuf + offset;
+
+    return ((self->capacity - offset) < len) ? (self->capacity - offset) : len;
+}
+
+void simple_spsc_fifo_write_commit(simple_spsc_fifo_t self, uint32_t length)
+{
+    uint32_t head = 0;
+
+    assert(self);
+    head = atomic_load_explicit(&self->head, memory_order_relaxed);
+    atomic_store_explicit(&self->head, head + length, memory_order_release);
+}
+
+uint32_t simple_spsc_fifo_read_peek(simple_spsc_fifo_t self, const uint8_t **pptr)
+{
+    uint32_t tail = 0, len = 0, offset = 0;
+
+    assert(self);
+    assert(pptr);
+    tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    len = atomic_load_explicit(&self->head, memory_order_acquire) - tail;
+    offset = tail & (self->capacity - 1);
+    *pptr = self->pbuf + offset;
+
+    return ((self->capacity - offset) < len) ? (self->capacity - offset) : len;
+}
+
+void simple_spsc_fifo_read_release(simple_spsc_fifo_t self, uint32_t length)
+{
+    uint32_t tail = 0;
+
+    assert(self);
+    tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    atomic_store_explicit(&self->tail, tail + length, memory_order_release);
+}
@@ -32,8 +32,22 @@ extern "C"
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "lists.h"
 
 /*---------- macro ----------*/
+/* Returned by soft_timer_get_next_expiry() if no timer is active. */
+#define SOFT_TIMER_NO_EXPIRY                (0xFFFFFFFFUL)
+
+/* Buckets of the lag histogram, bucket 0 counts no lag, bucket n counts a lag of
+ * [2^(n-1), 2^n) ticks and the last one all longer lags. */
+#define SOFT_TIMER_STATS_LAG_BUCKETS        (12)
+
+/**
+ * @brief Define a static timer named name, soft_timer_init_static(&name, ...) initializes
+ * it and returns the handle without the heap.
+ */
+#define SOFT_TIMER_DEFINE(name)             static struct timer_tcb name
+
 /*---------- type define ----------*/
 typedef enum {
     SFTIM_MODE_SINGLE = 0,
@@ -44,6 +58,49 @@ typedef struct timer_tcb *timer_handle_t;
 
 typedef void (*timer_cb_t)(timer_handle_t);
 
+typedef void (*timer_dispatch_t)(timer_handle_t);
+
+/* Collected per timer when CONFIG_SOFT_TIMER_STATS is defined. The lag is the ticks from
+ * the expiry to the dispatch by soft_timer_poll(), the execute time is measured in units
+ * of CONFIG_SOFT_TIMER_STATS_TIMESTAMP().
+ */
+struct soft_timer_stats {
+    uint32_t dispatch_count;
+    uint32_t lag_histogram[SOFT_TIMER_STATS_LAG_BUCKETS];
+    uint32_t lag_max;
+    uint32_t execute_max;
+    uint64_t execute_total;
+    uint32_t missed_periods;    /*<< Periods of a repeat timer lost to the lag */
+};
+
+/* The members are private, the definition is only public to place a timer statically
+ * or inside the object owning it. CONFIG_SOFT_TIMER_TIMING_WHEEL and CONFIG_SOFT_TIMER_STATS
+ * change the control block, so they must be the same for every file including this one.
+ */
+struct timer_tcb {
+    struct list_head node;
+    soft_timer_mode_t mode;
+    const char *name;
+    uint32_t remaining;
+    uint32_t period;
+    uint32_t slack;             /*<< The ticks the expiry may be deferred by */
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+    uint32_t expires;           /*<< The tick on which the timer expires */
+#endif
+    void *user_data;
+    bool is_static;             /*<< Placed by soft_timer_init_static(), not freed by destroy */
+#ifdef CONFIG_SOFT_TIMER_STATS
+    struct list_head stats_node;
+    uint32_t expired_at;        /*<< The tick on which the timer moved to the ready list */
+    struct soft_timer_stats stats;
+#endif
+    struct {
+        void (*cb)(timer_handle_t tcb);
+        void (*insert)(timer_handle_t tcb);
+        void (*remove)(timer_handle_t tcb);
+    } ops;
+};
+
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 /**
@@ -71,7 +128,43 @@ typedef void (*timer_cb_t)(timer_handle_t);
 extern timer_handle_t soft_timer_create(const char *name, soft_timer_mode_t mode, uint32_t period, void *user_data, timer_cb_t cb);
 
 /**
- * @brief Delete a timer that was previously created using the soft_timer_create() API function
+ * @brief Create a new software timer instance with a slack, the timer expires up to slack
+ * ticks later than its period, so that timers with loose deadlines are merged into one wakeup.
+ * The expiry is deferred to the tick inside the window whose low bits are all zero, timers
+ * whose windows overlap then tend to expire on the same tick.
+ * @param name A text name that is assigned to the timer.
+ * @param mode SFTIM_MODE_REPEAT or SFTIM_MODE_SINGLE, see soft_timer_create().
+ * @param period The timer period in ticks.
+ * @param slack The ticks the expiry may be deferred by, 0 makes it the same as soft_timer_create().
+ * @param user_data User private data pointer.
+ * @param cb The function to call when the timer expires.
+ *
+ * @retval If the timer is successfully created then a handle to the newly created timer is returned.
+ * If not, NULL is returned.
+ */
+extern timer_handle_t soft_timer_create_with_slack(const char *name, soft_timer_mode_t mode, uint32_t period, uint32_t slack,
+                                                   void *user_data, timer_cb_t cb);
+
+/**
+ * @brief Initialize a software timer on caller-supplied storage, e.g. a SOFT_TIMER_DEFINE()
+ * object or a struct timer_tcb member of the object owning the timer, and return its handle.
+ * No heap is used, the timer is in the dormant state like a timer from soft_timer_create().
+ * @param storage The storage of the timer, it must stay valid until soft_timer_destroy().
+ * @param name A text name that is assigned to the timer.
+ * @param mode SFTIM_MODE_REPEAT or SFTIM_MODE_SINGLE, see soft_timer_create().
+ * @param period The timer period in ticks.
+ * @param slack The ticks the expiry may be deferred by, see soft_timer_create_with_slack().
+ * @param user_data User private data pointer.
+ * @param cb The function to call when the timer expires.
+ *
+ * @retval If the parameters are valid, the handle of the timer is returned, otherwise NULL.
+ */
+extern timer_handle_t soft_timer_init_static(struct timer_tcb *storage, const char *name, soft_timer_mode_t mode,
+                                             uint32_t period, uint32_t slack, void *user_data, timer_cb_t cb);
+
+/**
+ * @brief Delete a timer that was previously created using the soft_timer_create() API function,
+ * or detach a timer from soft_timer_init_static(), its storage is not freed.
  * @param timer The handle of the timer being deleted.
  * 
  * @retval None
@@ -187,6 +280,24 @@ extern void *soft_timer_get_user_data(timer_handle_t timer);
  */
 extern void soft_timer_poll(void);
 
+/**
+ * @brief The same as soft_timer_poll(), but every expired timer is handed to dispatch instead
+ * of running its callback, e.g. to queue it to a worker thread which calls soft_timer_execute().
+ * soft_timer_poll() is soft_timer_dispatch(soft_timer_execute).
+ * @param dispatch The function called with the handle of every expired timer.
+ *
+ * @retval None
+ */
+extern void soft_timer_dispatch(timer_dispatch_t dispatch);
+
+/**
+ * @brief Run the callback of a timer handed out by soft_timer_dispatch().
+ * @param timer The handle of the expired timer.
+ *
+ * @retval None
+ */
+extern void soft_timer_execute(timer_handle_t timer);
+
 /**
  * @brief Timer tick handle, it should be called on every tick.
  * 
@@ -194,6 +305,64 @@ extern void soft_timer_poll(void);
  */
 extern void soft_timer_tick(void);
 
+/**
+ * @brief Query the ticks until the next timer expires, so that a tickless port can program
+ * a one-shot hardware timer and sleep until then.
+ * With CONFIG_SOFT_TIMER_TIMING_WHEEL, timers in the upper levels of the wheel are reported
+ * at the tick they are cascaded, the port wakes up earlier and simply queries again.
+ *
+ * @retval 0 if some timers are waiting for soft_timer_poll(), SOFT_TIMER_NO_EXPIRY if no
+ * timer is active, otherwise the number of ticks after which a timer expires.
+ */
+extern uint32_t soft_timer_get_next_expiry(void);
+
+/**
+ * @brief Catch up with the ticks elapsed while the periodic tick was stopped, it has the
+ * same effect as calling soft_timer_tick() elapsed times, but runs in one step.
+ * A repeat timer is started again by soft_timer_poll(), so it expires at most once
+ * during one call.
+ * @param elapsed The ticks elapsed since the last soft_timer_tick() or soft_timer_advance().
+ *
+ * @retval None
+ */
+extern void soft_timer_advance(uint32_t elapsed);
+
+/**
+ * @brief Query how many timer expirations were merged into the wakeup of another timer,
+ * i.e. the expirations on a tick beyond the first one.
+ *
+ * @retval The number of saved wakeups.
+ */
+extern uint32_t soft_timer_get_saved_wakeups(void);
+
+#ifdef CONFIG_SOFT_TIMER_STATS
+/**
+ * @brief Copy the stats of a timer.
+ * @param timer The handle of the timer being queried.
+ * @param pstats The container of the stats.
+ *
+ * @retval None
+ */
+extern void soft_timer_get_stats(timer_handle_t timer, struct soft_timer_stats *pstats);
+
+/**
+ * @brief Clear the stats of a timer.
+ * @param timer The handle of the timer.
+ *
+ * @retval None
+ */
+extern void soft_timer_reset_stats(timer_handle_t timer);
+
+/**
+ * @brief Print the stats of the timers with the longest callbacks by name through xlog,
+ * worst first.
+ * @param count The maximum number of timers printed.
+ *
+ * @retval None
+ */
+extern void soft_timer_dump_stats(uint32_t count);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,68 @@
+/**
+ * @file common/soft_timer/inc/soft_timer_service.h
+ *
+ * Copyright (C) 2024
+ *
+ * soft_timer_service.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ *
+ * @encoding utf-8
+ */
+#ifndef __SOFT_TIMER_SERVICE_H
+#define __SOFT_TIMER_SERVICE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*---------- macro ----------*/
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/**
+ * @brief Drive the soft timers from threads on the POSIX host, built with
+ * CONFIG_SOFT_TIMER_SERVICE. One expiry thread calls soft_timer_advance() every tick
+ * and hands the expired timers to a pool of worker threads which run the callbacks.
+ * Timers with the same user data, i.e. timers of the same object, always run on the
+ * same worker, so their callbacks are serialized and keep the expiry order.
+ * __enter_critical() and __exit_critical() of the port must lock a mutex shared by
+ * all threads. A timer must not be destroyed while its callback may still be queued,
+ * destroy it in a callback with the same user data or after soft_timer_service_stop().
+ * @param tick_us The tick period in microseconds.
+ * @param worker_count The number of worker threads.
+ *
+ * @retval If all threads are started, return true, otherwise return false.
+ */
+extern bool soft_timer_service_start(uint32_t tick_us, uint32_t worker_count);
+
+/**
+ * @brief Stop the expiry thread, wait until the workers have run the callbacks already
+ * queued and stop them.
+ * @param None
+ *
+ * @retval None
+ */
+extern void soft_timer_service_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __SOFT_TIMER_SERVICE_H */
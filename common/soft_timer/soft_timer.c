@@ -26,25 +26,52 @@
 #include "lists.h"
 #include "options.h"
 #include <string.h>
+#ifdef CONFIG_SOFT_TIMER_USE_MEM_POOL
+#include "mem_pool.h"
+#endif
 
 /*---------- macro ----------*/
 #define TAG                                 "SoftTimer"
 
-/*---------- type define ----------*/
-struct timer_tcb {
-    struct list_head node;
-    soft_timer_mode_t mode;
-    const char *name;
-    uint32_t remaining;
-    uint32_t period;
-    void *user_data;
-    struct {
-        void (*cb)(timer_handle_t tcb);
-        void (*insert)(timer_handle_t tcb);
-        void (*remove)(timer_handle_t tcb);
-    } ops;
-};
+#ifndef CONFIG_SOFT_TIMER_POOL_CHUNK_COUNT
+#define CONFIG_SOFT_TIMER_POOL_CHUNK_COUNT  (8)
+#endif
+
+/* Define CONFIG_SOFT_TIMER_TIMING_WHEEL to keep the active timers in a hierarchical
+ * timing wheel instead of a sorted delta list, start and stop become O(1) and the tick
+ * cascades one slot of the upper level every 2^CONFIG_SOFT_TIMER_WHEEL_BITS ticks. The
+ * wheel takes 2^CONFIG_SOFT_TIMER_WHEEL_BITS * CONFIG_SOFT_TIMER_WHEEL_LEVELS list heads,
+ * timers beyond the last level are parked in its farthest slot and cascaded again.
+ */
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+#ifndef CONFIG_SOFT_TIMER_WHEEL_BITS
+#define CONFIG_SOFT_TIMER_WHEEL_BITS        (6)
+#endif
+#ifndef CONFIG_SOFT_TIMER_WHEEL_LEVELS
+#define CONFIG_SOFT_TIMER_WHEEL_LEVELS      (4)
+#endif
+
+#define SOFT_TIMER_WHEEL_SIZE               (1UL << CONFIG_SOFT_TIMER_WHEEL_BITS)
+#define SOFT_TIMER_WHEEL_MASK               (SOFT_TIMER_WHEEL_SIZE - 1)
+#define SOFT_TIMER_WHEEL_SHIFT(level)       ((level) * CONFIG_SOFT_TIMER_WHEEL_BITS)
+#define SOFT_TIMER_WHEEL_INDEX(tick, level) (((tick) >> SOFT_TIMER_WHEEL_SHIFT(level)) & SOFT_TIMER_WHEEL_MASK)
+
+#if ((CONFIG_SOFT_TIMER_WHEEL_BITS * CONFIG_SOFT_TIMER_WHEEL_LEVELS) > 32)
+#error "The timing wheel can not cover more than 32 bits of ticks"
+#endif
+#endif
+
+/* Define CONFIG_SOFT_TIMER_STATS to collect soft_timer_stats per timer. The callback
+ * time is measured by CONFIG_SOFT_TIMER_STATS_TIMESTAMP(), define it to a cycle counter
+ * on the port for a finer resolution than the system tick.
+ */
+#ifdef CONFIG_SOFT_TIMER_STATS
+#ifndef CONFIG_SOFT_TIMER_STATS_TIMESTAMP
+#define CONFIG_SOFT_TIMER_STATS_TIMESTAMP()     ((uint32_t)__get_ticks())
+#endif
+#endif
 
+/*---------- type define ----------*/
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
 static void _remove_from_ready_list(timer_handle_t tcb);
@@ -55,7 +82,20 @@ static void _insert_to_active_list(timer_handle_t tcb);
 /*---------- variable ----------*/
 static LIST_HEAD(_timer_ready_list);        /*<< Mount all timers that due now */
 static LIST_HEAD(_timer_active_list);       /*<< Mount all timers that are running */
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+static struct list_head _timer_wheel[CONFIG_SOFT_TIMER_WHEEL_LEVELS][SOFT_TIMER_WHEEL_SIZE];
+static bool _timer_wheel_ready;
+#else
 static uint32_t _timer_count;               /*<< The expiry time of the first timer on the active list */
+#endif
+static uint32_t _timer_jiffies;             /*<< The tick handled by the next soft_timer_tick() */
+static uint32_t _timer_saved_wakeups;       /*<< Expirations merged into the wakeup of another timer */
+#ifdef CONFIG_SOFT_TIMER_STATS
+static LIST_HEAD(_timer_stats_list);        /*<< Mount all timers, so the stats can be dumped */
+#endif
+#ifdef CONFIG_SOFT_TIMER_USE_MEM_POOL
+static mem_pool_t _timer_pool;              /*<< Fixed-size pool of all timer tcbs */
+#endif
 
 /*---------- function ----------*/
 static inline void _lock(void)
@@ -68,6 +108,53 @@ static inline void _unlock(void)
     __exit_critical();
 }
 
+static timer_handle_t _tcb_alloc(void)
+{
+#ifdef CONFIG_SOFT_TIMER_USE_MEM_POOL
+    mem_pool_t pool = mem_pool_get_or_create(&_timer_pool, sizeof(struct timer_tcb),
+                                             CONFIG_SOFT_TIMER_POOL_CHUNK_COUNT);
+
+    return (pool ? mem_pool_alloc(pool) : NULL);
+#else
+    return __malloc(sizeof(struct timer_tcb));
+#endif
+}
+
+static void _tcb_free(timer_handle_t tcb)
+{
+#ifdef CONFIG_SOFT_TIMER_USE_MEM_POOL
+    mem_pool_free(_timer_pool, tcb);
+#else
+    __free(tcb);
+#endif
+}
+
+/* The ticks from now to the expiry of the tcb. The deadline is deferred within the
+ * slack to the tick with the most trailing zero bits, so timers whose slack windows
+ * overlap tend to expire on the same tick and share one wakeup.
+ */
+static uint32_t _get_expiry_ticks(timer_handle_t tcb)
+{
+    uint32_t expires = _timer_jiffies + tcb->period - 1, limit = 0, mask = 0;
+    uint32_t ticks = tcb->period;
+
+    if(tcb->slack) {
+        limit = expires + tcb->slack;
+        mask = expires ^ limit;
+        mask |= mask >> 1;
+        mask |= mask >> 2;
+        mask |= mask >> 4;
+        mask |= mask >> 8;
+        mask |= mask >> 16;
+        limit &= ~(mask >> 1);
+        if((limit - expires) <= tcb->slack) {
+            ticks += limit - expires;
+        }
+    }
+
+    return ticks;
+}
+
 static void _remove_from_ready_list(timer_handle_t tcb)
 {
     list_del(&tcb->node);
@@ -75,6 +162,14 @@ static void _remove_from_ready_list(timer_handle_t tcb)
     tcb->ops.insert = _insert_to_active_list;
 }
 
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+static void _remove_from_active_list(timer_handle_t tcb)
+{
+    list_del(&tcb->node);
+    tcb->ops.remove = NULL;
+    tcb->ops.insert = _insert_to_ready_list;
+}
+#else
 static void _remove_from_active_list(timer_handle_t tcb)
 {
     /* update the first active tcb's remaining value */
@@ -86,34 +181,86 @@ static void _remove_from_active_list(timer_handle_t tcb)
     /* remove tcb from active list */
     list_del(&tcb->node);
     /* update timer count */
-    _timer_count = list_first_entry(&_timer_active_list, struct timer_tcb, node)->remaining;
+    if(list_empty_careful(&_timer_active_list) != true) {
+        _timer_count = list_first_entry(&_timer_active_list, struct timer_tcb, node)->remaining;
+    }
     tcb->ops.remove = NULL;
     tcb->ops.insert = _insert_to_ready_list;
 }
+#endif
 
 static void _insert_to_ready_list(timer_handle_t tcb)
 {
+#ifdef CONFIG_SOFT_TIMER_STATS
+    tcb->expired_at = _timer_jiffies;
+#endif
     list_add_tail(&tcb->node, &_timer_ready_list);
     tcb->ops.remove = _remove_from_ready_list;
     tcb->ops.insert = NULL;
 }
 
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+static void _wheel_init(void)
+{
+    for(uint32_t level = 0; level < CONFIG_SOFT_TIMER_WHEEL_LEVELS; ++level) {
+        for(uint32_t i = 0; i < SOFT_TIMER_WHEEL_SIZE; ++i) {
+            INIT_LIST_HEAD(&_timer_wheel[level][i]);
+        }
+    }
+    _timer_wheel_ready = true;
+}
+
+/* Place the tcb in the lowest level whose range covers its expiry, measured from
+ * the next tick to be handled. */
+static void _wheel_place(timer_handle_t tcb)
+{
+    uint32_t delta = tcb->expires - _timer_jiffies, expires = tcb->expires, level = 0;
+
+    if((int32_t)delta < 0) {
+        /* already due, handle it on the next tick */
+        expires = _timer_jiffies;
+    } else {
+        while((level + 1) < CONFIG_SOFT_TIMER_WHEEL_LEVELS &&
+              delta >= (SOFT_TIMER_WHEEL_SIZE << SOFT_TIMER_WHEEL_SHIFT(level))) {
+            level++;
+        }
+        if(SOFT_TIMER_WHEEL_SHIFT(level + 1) < 32 &&
+           delta >= (SOFT_TIMER_WHEEL_SIZE << SOFT_TIMER_WHEEL_SHIFT(level))) {
+            /* beyond the wheel, park it in the farthest slot of the last level */
+            expires = _timer_jiffies + (SOFT_TIMER_WHEEL_MASK << SOFT_TIMER_WHEEL_SHIFT(level));
+        }
+    }
+    list_add_tail(&tcb->node, &_timer_wheel[level][SOFT_TIMER_WHEEL_INDEX(expires, level)]);
+}
+
+static void _insert_to_active_list(timer_handle_t tcb)
+{
+    if(!_timer_wheel_ready) {
+        _wheel_init();
+    }
+    /* the timer expires on the period-th tick from now */
+    tcb->expires = _timer_jiffies + _get_expiry_ticks(tcb) - 1;
+    _wheel_place(tcb);
+    tcb->ops.remove = _remove_from_active_list;
+    tcb->ops.insert = NULL;
+}
+#else
 static void _insert_to_active_list(timer_handle_t tcb)
 {
     timer_handle_t iter = NULL, n = NULL;
-    uint32_t remaining_total = 0;
+    uint32_t remaining_total = 0, period = _get_expiry_ticks(tcb);
     bool insertion_point_found = false;
 
     if(list_empty_careful(&_timer_active_list)) {
         list_add(&tcb->node, &_timer_active_list);
-        tcb->remaining = tcb->period;
+        tcb->remaining = period;
         _timer_count = tcb->remaining;
     } else {
         /* update the first active tcb's remaining value */
         list_first_entry(&_timer_active_list, struct timer_tcb, node)->remaining = _timer_count;
         list_for_each_entry(iter, struct timer_tcb, &_timer_active_list, node) {
             remaining_total += iter->remaining;
-            if(remaining_total > tcb->period) {
+            if(remaining_total > period) {
                 insertion_point_found = true;
                 break;
             }
@@ -124,11 +271,11 @@ static void _insert_to_active_list(timer_handle_t tcb)
             list_add(&tcb->node, &n->node);
             /* calc the remaining value */
             remaining_total -= iter->remaining;
-            tcb->remaining = tcb->period - remaining_total;
+            tcb->remaining = period - remaining_total;
             iter->remaining -= tcb->remaining;
         } else {
             /* insert to the list last */
-            tcb->remaining = tcb->period - remaining_total;
+            tcb->remaining = period - remaining_total;
             list_add_tail(&tcb->node, &_timer_active_list);
         }
         /* update timer count */
@@ -137,10 +284,16 @@ static void _insert_to_active_list(timer_handle_t tcb)
     tcb->ops.remove = _remove_from_active_list;
     tcb->ops.insert = NULL;
 }
+#endif
 
 timer_handle_t soft_timer_create(const char *name, soft_timer_mode_t mode, uint32_t period, void *user_data, timer_cb_t cb)
 {
-    timer_handle_t tcb = NULL;
+    return soft_timer_create_with_slack(name, mode, period, 0, user_data, cb);
+}
+
+static bool _tcb_check(soft_timer_mode_t mode, uint32_t period)
+{
+    bool retval = false;
 
     do {
         if(!period) {
@@ -151,25 +304,67 @@ timer_handle_t soft_timer_create(const char *name, soft_timer_mode_t mode, uint3
             xlog_tag_error(TAG, "SoftTimer's mode para format error\n");
             break;
         }
-        tcb = __malloc(sizeof(struct timer_tcb));
+        retval = true;
+    } while(0);
+
+    return retval;
+}
+
+static void _tcb_setup(timer_handle_t tcb, const char *name, soft_timer_mode_t mode, uint32_t period, uint32_t slack,
+                       void *user_data, timer_cb_t cb, bool is_static)
+{
+    memset(tcb, 0, sizeof(struct timer_tcb));
+    INIT_LIST_HEAD(&tcb->node);
+    tcb->name = name;
+    tcb->mode = mode;
+    tcb->period = period;
+    tcb->slack = slack;
+    tcb->remaining = period;
+    tcb->user_data = user_data;
+    tcb->is_static = is_static;
+    tcb->ops.cb = cb;
+    tcb->ops.insert = _insert_to_active_list;
+#ifdef CONFIG_SOFT_TIMER_STATS
+    _lock();
+    list_add_tail(&tcb->stats_node, &_timer_stats_list);
+    _unlock();
+#endif
+}
+
+timer_handle_t soft_timer_create_with_slack(const char *name, soft_timer_mode_t mode, uint32_t period, uint32_t slack,
+                                            void *user_data, timer_cb_t cb)
+{
+    timer_handle_t tcb = NULL;
+
+    do {
+        if(!_tcb_check(mode, period)) {
+            break;
+        }
+        tcb = _tcb_alloc();
         if(!tcb) {
             xlog_tag_error(TAG, "No memory to alloc new tiemr tcb\n");
             break;
         }
-        memset(tcb, 0, sizeof(struct timer_tcb));
-        INIT_LIST_HEAD(&tcb->node);
-        tcb->name = name;
-        tcb->mode = mode;
-        tcb->period = period;
-        tcb->remaining = period;
-        tcb->user_data = user_data;
-        tcb->ops.cb = cb;
-        tcb->ops.insert = _insert_to_active_list;
+        _tcb_setup(tcb, name, mode, period, slack, user_data, cb, false);
     } while(0);
 
     return tcb;
 }
 
+timer_handle_t soft_timer_init_static(struct timer_tcb *storage, const char *name, soft_timer_mode_t mode, uint32_t period,
+                                      uint32_t slack, void *user_data, timer_cb_t cb)
+{
+    timer_handle_t tcb = NULL;
+
+    assert(storage);
+    if(_tcb_check(mode, period)) {
+        tcb = storage;
+        _tcb_setup(tcb, name, mode, period, slack, user_data, cb, true);
+    }
+
+    return tcb;
+}
+
 void soft_timer_destroy(timer_handle_t tcb)
 {
     assert(tcb);
@@ -178,7 +373,14 @@ void soft_timer_destroy(timer_handle_t tcb)
         tcb->ops.remove(tcb);
         _unlock();
     }
-    __free(tcb);
+#ifdef CONFIG_SOFT_TIMER_STATS
+    _lock();
+    list_del(&tcb->stats_node);
+    _unlock();
+#endif
+    if(!tcb->is_static) {
+        _tcb_free(tcb);
+    }
 }
 
 void soft_timer_start(timer_handle_t tcb)
@@ -269,16 +471,51 @@ void *soft_timer_get_user_data(timer_handle_t tcb)
     return tcb->user_data;
 }
 
-void soft_timer_poll(void)
+#ifdef CONFIG_SOFT_TIMER_STATS
+/* Called before the callback, the lag is counted from the end of the tick on which
+ * the timer expired. */
+static void _stats_dispatch(timer_handle_t tcb)
+{
+    struct soft_timer_stats *pstats = &tcb->stats;
+    uint32_t lag = _timer_jiffies - tcb->expired_at - 1, bucket = 0;
+
+    while(bucket < (SOFT_TIMER_STATS_LAG_BUCKETS - 1) && (lag >> bucket)) {
+        bucket++;
+    }
+    pstats->lag_histogram[bucket]++;
+    pstats->lag_max = (lag > pstats->lag_max) ? lag : pstats->lag_max;
+    pstats->dispatch_count++;
+    /* a repeat timer is started again on dispatch, the periods within the lag are lost */
+    if(tcb->mode == SFTIM_MODE_REPEAT) {
+        pstats->missed_periods += lag / tcb->period;
+    }
+}
+
+/* The callbacks may run on the workers of the soft timer service, the update is locked
+ * like the readers and the reset of the stats. */
+static void _stats_execute(timer_handle_t tcb, uint32_t time)
+{
+    _lock();
+    tcb->stats.execute_max = (time > tcb->stats.execute_max) ? time : tcb->stats.execute_max;
+    tcb->stats.execute_total += time;
+    _unlock();
+}
+#endif
+
+void soft_timer_dispatch(timer_dispatch_t dispatch)
 {
     timer_handle_t tcb = NULL;
 
+    assert(dispatch);
     while(list_empty_careful(&_timer_ready_list) != true) {
         _lock();
         if(NULL == (tcb = list_first_entry_or_null(&_timer_ready_list, struct timer_tcb, node))) {
             _unlock();
             break;
         }
+#ifdef CONFIG_SOFT_TIMER_STATS
+        _stats_dispatch(tcb);
+#endif
         /* remove from ready list */
         tcb->ops.remove(tcb);
         /* insert to active list */
@@ -286,39 +523,275 @@ void soft_timer_poll(void)
             tcb->ops.insert(tcb);
         }
         _unlock();
-        if(tcb->ops.cb) {
-            tcb->ops.cb(tcb);
+        dispatch(tcb);
+    }
+}
+
+void soft_timer_execute(timer_handle_t tcb)
+{
+#ifdef CONFIG_SOFT_TIMER_STATS
+    uint32_t timestamp = 0;
+#endif
+
+    assert(tcb);
+    if(tcb->ops.cb) {
+#ifdef CONFIG_SOFT_TIMER_STATS
+        timestamp = CONFIG_SOFT_TIMER_STATS_TIMESTAMP();
+        tcb->ops.cb(tcb);
+        _stats_execute(tcb, CONFIG_SOFT_TIMER_STATS_TIMESTAMP() - timestamp);
+#else
+        tcb->ops.cb(tcb);
+#endif
+    }
+}
+
+void soft_timer_poll(void)
+{
+    soft_timer_dispatch(soft_timer_execute);
+}
+
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+/* Move the timers of the current slot of a level to the lower levels, the slot index
+ * is returned, 0 means the next level has to be cascaded as well. */
+static uint32_t _wheel_cascade(uint32_t level)
+{
+    struct list_head list;
+    timer_handle_t tcb = NULL, next_tcb = NULL;
+    uint32_t index = SOFT_TIMER_WHEEL_INDEX(_timer_jiffies, level);
+
+    INIT_LIST_HEAD(&list);
+    list_splice_init(&_timer_wheel[level][index], &list);
+    list_for_each_entry_safe(tcb, next_tcb, struct timer_tcb, &list, node) {
+        _wheel_place(tcb);
+    }
+
+    return index;
+}
+
+/* Handle the tick of _timer_jiffies, the caller holds the lock. */
+static void _wheel_tick(void)
+{
+    timer_handle_t tcb = NULL, next_tcb = NULL;
+    struct list_head *pslot = NULL;
+    uint32_t count = 0;
+
+    if(_timer_wheel_ready) {
+        if(0 == SOFT_TIMER_WHEEL_INDEX(_timer_jiffies, 0)) {
+            for(uint32_t level = 1; level < CONFIG_SOFT_TIMER_WHEEL_LEVELS; ++level) {
+                if(0 != _wheel_cascade(level)) {
+                    break;
+                }
+            }
+        }
+        pslot = &_timer_wheel[0][SOFT_TIMER_WHEEL_INDEX(_timer_jiffies, 0)];
+        list_for_each_entry_safe(tcb, next_tcb, struct timer_tcb, pslot, node) {
+            tcb->ops.remove(tcb);
+            tcb->ops.insert(tcb);
+            count++;
+        }
+        _timer_saved_wakeups += count ? (count - 1) : 0;
+    }
+    _timer_jiffies++;
+}
+
+/* The ticks which can be skipped before a tick that expires or cascades a timer,
+ * SOFT_TIMER_NO_EXPIRY if the wheel is empty. Skipping the ticks of empty slots is
+ * the same as handling them, so the result is exact for soft_timer_advance(). */
+static uint32_t _wheel_next(void)
+{
+    uint32_t next = SOFT_TIMER_NO_EXPIRY, base = _timer_jiffies, index = 0, skip = 0;
+
+    for(uint32_t level = 0; _timer_wheel_ready && level < CONFIG_SOFT_TIMER_WHEEL_LEVELS; ++level) {
+        /* the first tick on which the slots of this level are cascaded */
+        if(level) {
+            base = (_timer_jiffies + (1UL << SOFT_TIMER_WHEEL_SHIFT(level)) - 1) &
+                   ~((1UL << SOFT_TIMER_WHEEL_SHIFT(level)) - 1);
+        }
+        index = SOFT_TIMER_WHEEL_INDEX(base, level);
+        for(uint32_t i = 0; i < SOFT_TIMER_WHEEL_SIZE; ++i) {
+            if(!list_empty(&_timer_wheel[level][(index + i) & SOFT_TIMER_WHEEL_MASK])) {
+                skip = base - _timer_jiffies + (i << SOFT_TIMER_WHEEL_SHIFT(level));
+                next = (skip < next) ? skip : next;
+                break;
+            }
         }
     }
+
+    return next;
 }
 
 void soft_timer_tick(void)
+{
+    _lock();
+    _wheel_tick();
+    _unlock();
+}
+
+void soft_timer_advance(uint32_t elapsed)
+{
+    uint32_t skip = 0;
+
+    _lock();
+    while(elapsed) {
+        skip = _wheel_next();
+        if(skip >= elapsed) {
+            _timer_jiffies += elapsed;
+            break;
+        }
+        _timer_jiffies += skip;
+        elapsed -= skip + 1;
+        _wheel_tick();
+    }
+    _unlock();
+}
+
+static uint32_t _next_expiry(void)
+{
+    uint32_t skip = _wheel_next();
+
+    return (SOFT_TIMER_NO_EXPIRY == skip) ? skip : (skip + 1);
+}
+#else
+/* Move the expired timers at the head of the active list to the ready list, the
+ * caller holds the lock. */
+static void _active_list_expire(void)
 {
     timer_handle_t tcb = NULL, next_tcb = NULL;
+    uint32_t count = 0;
+
+    if(NULL != (tcb = list_first_entry_or_null(&_timer_active_list, struct timer_tcb, node))) {
+        tcb->remaining = 0;
+        list_for_each_entry_safe(tcb, next_tcb, struct timer_tcb, &_timer_active_list, node) {
+            if(tcb->remaining == 0) {
+                /* When the current timer expires and is being processed in a systick interrupt,
+                * a higher priority interrupt occurs and happens to execute soft_timer_start(),
+                * soft_timer_restart() or soft_timer_change_period() to reset this timer it will
+                * cause the remove callback pointer to be NULL.
+                */
+                if(tcb->ops.remove) {
+                    tcb->ops.remove(tcb);
+                    tcb->ops.insert(tcb);
+                    count++;
+                    continue;
+                }
+                break;
+            }
+            _timer_count = tcb->remaining;
+            break;
+        }
+    }
+    _timer_saved_wakeups += count ? (count - 1) : 0;
+}
 
+void soft_timer_tick(void)
+{
     _timer_count--;
     if(_timer_count == 0 && list_empty_careful(&_timer_active_list) != true) {
         _lock();
-        if(NULL != (tcb = list_first_entry_or_null(&_timer_active_list, struct timer_tcb, node))) {
-            tcb->remaining = 0;
-            list_for_each_entry_safe(tcb, next_tcb, struct timer_tcb, &_timer_active_list, node) {
-                if(tcb->remaining == 0) {
-                    /* When the current timer expires and is being processed in a systick interrupt,
-                    * a higher priority interrupt occurs and happens to execute soft_timer_start(),
-                    * soft_timer_restart() or soft_timer_change_period() to reset this timer it will
-                    * cause the remove callback pointer to be NULL.
-                    */
-                    if(tcb->ops.remove) {
-                        tcb->ops.remove(tcb);
-                        tcb->ops.insert(tcb);
-                        continue;
-                    }
-                    break;
-                }
-                _timer_count = tcb->remaining;
-                break;
+        _active_list_expire();
+        _unlock();
+    }
+    _timer_jiffies++;
+}
+
+void soft_timer_advance(uint32_t elapsed)
+{
+    _lock();
+    while(elapsed && list_empty_careful(&_timer_active_list) != true && elapsed >= _timer_count) {
+        /* handle the tick on which the head expires */
+        _timer_jiffies += _timer_count - 1;
+        elapsed -= _timer_count;
+        _timer_count = 0;
+        _active_list_expire();
+        _timer_jiffies++;
+    }
+    _timer_count -= elapsed;
+    _timer_jiffies += elapsed;
+    _unlock();
+}
+
+static uint32_t _next_expiry(void)
+{
+    return list_empty_careful(&_timer_active_list) ? SOFT_TIMER_NO_EXPIRY : _timer_count;
+}
+#endif
+
+uint32_t soft_timer_get_next_expiry(void)
+{
+    uint32_t next = 0;
+
+    _lock();
+    if(list_empty_careful(&_timer_ready_list)) {
+        next = _next_expiry();
+    }
+    _unlock();
+
+    return next;
+}
+
+uint32_t soft_timer_get_saved_wakeups(void)
+{
+    return _timer_saved_wakeups;
+}
+
+#ifdef CONFIG_SOFT_TIMER_STATS
+void soft_timer_get_stats(timer_handle_t tcb, struct soft_timer_stats *pstats)
+{
+    assert(tcb);
+    assert(pstats);
+    _lock();
+    *pstats = tcb->stats;
+    _unlock();
+}
+
+void soft_timer_reset_stats(timer_handle_t tcb)
+{
+    assert(tcb);
+    _lock();
+    memset(&tcb->stats, 0, sizeof(tcb->stats));
+    _unlock();
+}
+
+void soft_timer_dump_stats(uint32_t count)
+{
+    timer_handle_t iter = NULL, worst = NULL, last = NULL;
+    struct soft_timer_stats stats;
+    const char *name = NULL;
+    uint32_t last_max = 0;
+
+    xlog_tag_info(TAG, "%-16s %10s %8s %10s %10s %8s\n", "name", "dispatch", "lag_max", "exec_max", "exec_avg", "missed");
+    for(uint32_t i = 0; i < count; ++i) {
+        /* the next timer ordered by the longest callback, ties are ordered by address */
+        _lock();
+        worst = NULL;
+        list_for_each_entry(iter, struct timer_tcb, &_timer_stats_list, stats_node) {
+            if(last && (iter->stats.execute_max > last_max ||
+                        (iter->stats.execute_max == last_max && iter >= last))) {
+                continue;
+            }
+            if(!worst || iter->stats.execute_max > worst->stats.execute_max ||
+               (iter->stats.execute_max == worst->stats.execute_max && iter > worst)) {
+                worst = iter;
             }
         }
+        /* the timer may be destroyed once unlocked, only last is kept to compare addresses */
+        if(worst) {
+            stats = worst->stats;
+            name = worst->name;
+        }
         _unlock();
+        if(!worst) {
+            break;
+        }
+        xlog_tag_info(TAG, "%-16s %10u %8u %10u %10u %8u\n", name ? name : "-",
+                      (unsigned int)stats.dispatch_count, (unsigned int)stats.lag_max,
+                      (unsigned int)stats.execute_max,
+                      (unsigned int)(stats.dispatch_count ? (stats.execute_total / stats.dispatch_count) : 0),
+                      (unsigned int)stats.missed_periods);
+        /* unused if xlog is compiled out */
+        (void)name;
+        last = worst;
+        last_max = stats.execute_max;
     }
 }
+#endif
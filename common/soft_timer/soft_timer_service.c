@@ -0,0 +1,303 @@
+/**
+ * @file common/soft_timer/soft_timer_service.c
+ *
+ * Copyright (C) 2024
+ *
+ * soft_timer_service.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note expiry thread and worker pool driving the soft timers, only for the
+ * POSIX host build
+ */
+
+/*---------- includes ----------*/
+#include "soft_timer_service.h"
+#include "soft_timer.h"
+#include "options.h"
+
+#ifdef CONFIG_SOFT_TIMER_SERVICE
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+/*---------- macro ----------*/
+#define TAG                                         "SoftTimerService"
+
+/* Expired timers a worker can hold, the expiry thread waits if the queue is full. */
+#ifndef CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE
+#define CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE        (256)
+#endif
+
+#if (CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE & (CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE - 1))
+#error "CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE must be a power of two"
+#endif
+
+#define SOFT_TIMER_SERVICE_QUEUE_MASK               (CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE - 1)
+
+/*---------- type define ----------*/
+struct worker {
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint32_t head;
+    uint32_t tail;
+    bool stop;                  /*<< Set after the expiry thread has left */
+    timer_handle_t queue[CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE];
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static struct worker *_workers;
+static uint32_t _worker_count;
+static uint32_t _tick_us;
+static pthread_t _expiry_thread;
+static _Atomic bool _running;
+#ifdef __linux__
+static int _timerfd = -1;
+#endif
+
+/*---------- function ----------*/
+/* Timers of the same object share the user data, so they share the worker. */
+static struct worker *_worker_of(timer_handle_t tcb)
+{
+    void *user_data = soft_timer_get_user_data(tcb);
+    uint64_t key = (uint64_t)(uintptr_t)(user_data ? user_data : (void *)tcb);
+
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDULL;
+    key ^= key >> 33;
+
+    return &_workers[key % _worker_count];
+}
+
+static void _dispatch(timer_handle_t tcb)
+{
+    struct worker *pworker = _worker_of(tcb);
+
+    pthread_mutex_lock(&pworker->mutex);
+    while((pworker->head - pworker->tail) == CONFIG_SOFT_TIMER_SERVICE_QUEUE_SIZE) {
+        pthread_cond_wait(&pworker->not_full, &pworker->mutex);
+    }
+    pworker->queue[pworker->head & SOFT_TIMER_SERVICE_QUEUE_MASK] = tcb;
+    pworker->head++;
+    pthread_cond_signal(&pworker->not_empty);
+    pthread_mutex_unlock(&pworker->mutex);
+}
+
+static void *_worker_entry(void *arg)
+{
+    struct worker *pworker = (struct worker *)arg;
+    timer_handle_t tcb = NULL;
+
+    pthread_mutex_lock(&pworker->mutex);
+    for(;;) {
+        while(pworker->head == pworker->tail && !pworker->stop) {
+            pthread_cond_wait(&pworker->not_empty, &pworker->mutex);
+        }
+        /* stopped, the queued callbacks are run before the worker exits */
+        if(pworker->head == pworker->tail) {
+            break;
+        }
+        tcb = pworker->queue[pworker->tail & SOFT_TIMER_SERVICE_QUEUE_MASK];
+        pworker->tail++;
+        pthread_cond_signal(&pworker->not_full);
+        pthread_mutex_unlock(&pworker->mutex);
+        soft_timer_execute(tcb);
+        pthread_mutex_lock(&pworker->mutex);
+    }
+    pthread_mutex_unlock(&pworker->mutex);
+
+    return NULL;
+}
+
+#ifdef __linux__
+/* The timerfd counts the ticks missed while the thread was not scheduled, they are
+ * caught up in one step. */
+static void *_expiry_entry(void *arg)
+{
+    uint64_t expirations = 0;
+
+    while(atomic_load(&_running)) {
+        if(read(_timerfd, &expirations, sizeof(expirations)) == sizeof(expirations) && expirations) {
+            soft_timer_advance((uint32_t)expirations);
+            soft_timer_dispatch(_dispatch);
+        }
+    }
+
+    return arg;
+}
+
+static bool _clock_open(void)
+{
+    struct itimerspec spec = {0};
+    bool retval = false;
+
+    _timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if(_timerfd >= 0) {
+        spec.it_interval.tv_sec = _tick_us / 1000000UL;
+        spec.it_interval.tv_nsec = (long)(_tick_us % 1000000UL) * 1000L;
+        spec.it_value = spec.it_interval;
+        if(timerfd_settime(_timerfd, 0, &spec, NULL) == 0) {
+            retval = true;
+        } else {
+            close(_timerfd);
+            _timerfd = -1;
+        }
+    }
+
+    return retval;
+}
+
+static void _clock_close(void)
+{
+    if(_timerfd >= 0) {
+        close(_timerfd);
+        _timerfd = -1;
+    }
+}
+#else
+static uint64_t _now_us(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+}
+
+/* clock_nanosleep() is missing on e.g. macOS, so sleep with nanosleep() for the time left
+ * to the next deadline. The ticks missed by a late wakeup are caught up in one step. */
+static void *_expiry_entry(void *arg)
+{
+    struct timespec delay = {0};
+    uint64_t next = _now_us(), now = 0;
+    uint32_t elapsed = 0;
+
+    while(atomic_load(&_running)) {
+        next += _tick_us;
+        now = _now_us();
+        if(now < next) {
+            delay.tv_sec = (time_t)((next - now) / 1000000ULL);
+            delay.tv_nsec = (long)((next - now) % 1000000ULL) * 1000L;
+            while(nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+            }
+            now = _now_us();
+        }
+        elapsed = 1;
+        if(now > next) {
+            elapsed += (uint32_t)((now - next) / _tick_us);
+            next += (uint64_t)(elapsed - 1) * _tick_us;
+        }
+        soft_timer_advance(elapsed);
+        soft_timer_dispatch(_dispatch);
+    }
+
+    return arg;
+}
+
+static bool _clock_open(void)
+{
+    return true;
+}
+
+static void _clock_close(void)
+{
+}
+#endif
+
+static void _workers_stop(uint32_t count)
+{
+    for(uint32_t i = 0; i < count; ++i) {
+        pthread_mutex_lock(&_workers[i].mutex);
+        _workers[i].stop = true;
+        pthread_cond_broadcast(&_workers[i].not_empty);
+        pthread_mutex_unlock(&_workers[i].mutex);
+        pthread_join(_workers[i].thread, NULL);
+    }
+    for(uint32_t i = 0; i < _worker_count; ++i) {
+        pthread_cond_destroy(&_workers[i].not_full);
+        pthread_cond_destroy(&_workers[i].not_empty);
+        pthread_mutex_destroy(&_workers[i].mutex);
+    }
+    __free(_workers);
+    _workers = NULL;
+    _worker_count = 0;
+}
+
+bool soft_timer_service_start(uint32_t tick_us, uint32_t worker_count)
+{
+    uint32_t started = 0;
+    bool retval = false;
+
+    assert(tick_us);
+    assert(worker_count);
+    assert(!_workers);
+    do {
+        _workers = (struct worker *)__malloc(sizeof(struct worker) * worker_count);
+        if(!_workers) {
+            xlog_tag_error(TAG, "No memory to alloc the workers\n");
+            break;
+        }
+        memset(_workers, 0, sizeof(struct worker) * worker_count);
+        _worker_count = worker_count;
+        _tick_us = tick_us;
+        for(uint32_t i = 0; i < worker_count; ++i) {
+            pthread_mutex_init(&_workers[i].mutex, NULL);
+            pthread_cond_init(&_workers[i].not_empty, NULL);
+            pthread_cond_init(&_workers[i].not_full, NULL);
+        }
+        atomic_store(&_running, true);
+        for(started = 0; started < worker_count; ++started) {
+            if(pthread_create(&_workers[started].thread, NULL, _worker_entry, &_workers[started]) != 0) {
+                break;
+            }
+        }
+        if(started != worker_count || !_clock_open()) {
+            xlog_tag_error(TAG, "Start the workers or the tick clock failed\n");
+            atomic_store(&_running, false);
+            _workers_stop(started);
+            break;
+        }
+        if(pthread_create(&_expiry_thread, NULL, _expiry_entry, NULL) != 0) {
+            xlog_tag_error(TAG, "Start the expiry thread failed\n");
+            atomic_store(&_running, false);
+            _clock_close();
+            _workers_stop(started);
+            break;
+        }
+        retval = true;
+    } while(0);
+
+    return retval;
+}
+
+void soft_timer_service_stop(void)
+{
+    if(_workers) {
+        /* the expiry thread leaves within one tick, then nothing is queued any more */
+        atomic_store(&_running, false);
+        pthread_join(_expiry_thread, NULL);
+        _clock_close();
+        _workers_stop(_worker_count);
+    }
+}
+#endif
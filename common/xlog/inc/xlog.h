@@ -48,17 +48,99 @@ extern "C"
  */
 #define LOG_CONT                            "<c>"
 
+/* log level numbers, the same order as the prefixes above
+ */
+#define XLOG_LEVEL_OFF                      (-1)    /*<< no log */
+#define XLOG_LEVEL_ERROR                    (0)
+#define XLOG_LEVEL_WARN                     (1)
+#define XLOG_LEVEL_MESSAGE                  (2)
+#define XLOG_LEVEL_INFO                     (3)
+
+/* The least serious level compiled in. The xlog_<level>(), xlog_tag_<level>(),
+ * xlog_deferred_tag_<level>(), xlog_isr_tag_<level>() and xlog_module_<level>() of a
+ * less serious level expand to an empty statement, so neither the call nor the
+ * arguments are left in the image. e.g. define it to XLOG_LEVEL_WARN for a release
+ * image. xlog() with a level prefix written by hand is not filtered.
+ */
+#ifndef CONFIG_XLOG_LEVEL_MIN
+#define CONFIG_XLOG_LEVEL_MIN               XLOG_LEVEL_INFO
+#endif
+
+#if CONFIG_XLOG_LEVEL_MIN >= XLOG_LEVEL_ERROR
+#define __xlog_level_error(log, ...)        log(__VA_ARGS__)
+#else
+#define __xlog_level_error(log, ...)        do {} while(0)
+#endif
+#if CONFIG_XLOG_LEVEL_MIN >= XLOG_LEVEL_WARN
+#define __xlog_level_warn(log, ...)         log(__VA_ARGS__)
+#else
+#define __xlog_level_warn(log, ...)         do {} while(0)
+#endif
+#if CONFIG_XLOG_LEVEL_MIN >= XLOG_LEVEL_MESSAGE
+#define __xlog_level_message(log, ...)      log(__VA_ARGS__)
+#else
+#define __xlog_level_message(log, ...)      do {} while(0)
+#endif
+#if CONFIG_XLOG_LEVEL_MIN >= XLOG_LEVEL_INFO
+#define __xlog_level_info(log, ...)         log(__VA_ARGS__)
+#else
+#define __xlog_level_info(log, ...)         do {} while(0)
+#endif
+
 /* xlog API functions definition
  */
-#define xlog_error(x, ...)                  xlog(LOG_ERROR x, ##__VA_ARGS__)
-#define xlog_warn(x, ...)                   xlog(LOG_WARN x, ##__VA_ARGS__)
-#define xlog_message(x, ...)                xlog(LOG_MESSAGE x, ##__VA_ARGS__)
-#define xlog_info(x, ...)                   xlog(LOG_INFO x, ##__VA_ARGS__)
+#define xlog_error(x, ...)                  __xlog_level_error(xlog, LOG_ERROR x, ##__VA_ARGS__)
+#define xlog_warn(x, ...)                   __xlog_level_warn(xlog, LOG_WARN x, ##__VA_ARGS__)
+#define xlog_message(x, ...)                __xlog_level_message(xlog, LOG_MESSAGE x, ##__VA_ARGS__)
+#define xlog_info(x, ...)                   __xlog_level_info(xlog, LOG_INFO x, ##__VA_ARGS__)
 #define xlog_cont(x, ...)                   xlog(LOG_CONT x, ##__VA_ARGS__)
-#define xlog_tag_error(tag, x, ...)         xlog(LOG_ERROR "(" tag ")" x, ##__VA_ARGS__)
-#define xlog_tag_warn(tag, x, ...)          xlog(LOG_WARN "(" tag ")" x, ##__VA_ARGS__)
-#define xlog_tag_message(tag, x, ...)       xlog(LOG_MESSAGE "(" tag ")" x, ##__VA_ARGS__)
-#define xlog_tag_info(tag, x, ...)          xlog(LOG_INFO "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_tag_error(tag, x, ...)         __xlog_level_error(xlog, LOG_ERROR "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_tag_warn(tag, x, ...)          __xlog_level_warn(xlog, LOG_WARN "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_tag_message(tag, x, ...)       __xlog_level_message(xlog, LOG_MESSAGE "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_tag_info(tag, x, ...)          __xlog_level_info(xlog, LOG_INFO "(" tag ")" x, ##__VA_ARGS__)
+
+/* xlog deferred API functions definition, the format string must be a literal.
+ */
+#define xlog_deferred_tag_error(tag, x, ...)    __xlog_level_error(xlog_deferred, LOG_ERROR "(" tag ")" x, \
+                                                                   ##__VA_ARGS__)
+#define xlog_deferred_tag_warn(tag, x, ...)     __xlog_level_warn(xlog_deferred, LOG_WARN "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_deferred_tag_message(tag, x, ...)  __xlog_level_message(xlog_deferred, LOG_MESSAGE "(" tag ")" x, \
+                                                                     ##__VA_ARGS__)
+#define xlog_deferred_tag_info(tag, x, ...)     __xlog_level_info(xlog_deferred, LOG_INFO "(" tag ")" x, ##__VA_ARGS__)
+
+/* xlog API functions for interrupts definition
+ */
+#define xlog_isr_tag_error(tag, x, ...)     __xlog_level_error(xlog_isr, LOG_ERROR "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_isr_tag_warn(tag, x, ...)      __xlog_level_warn(xlog_isr, LOG_WARN "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_isr_tag_message(tag, x, ...)   __xlog_level_message(xlog_isr, LOG_MESSAGE "(" tag ")" x, ##__VA_ARGS__)
+#define xlog_isr_tag_info(tag, x, ...)      __xlog_level_info(xlog_isr, LOG_INFO "(" tag ")" x, ##__VA_ARGS__)
+
+/* Per-module levels changed at runtime. A module defines its level once with
+ * XLOG_MODULE_DEFINE(name, level) in a source file, XLOG_MODULE_DECLARE(name) makes it
+ * visible to other files. xlog_module_<level>(name, ...) logs with the tag "name" only if
+ * the level is at least as serious as the level of the module, the level is compared
+ * before the arguments are evaluated. The messages filtered out are not put into the
+ * log buffer either, unlike the console level of xlog_set_log_level().
+ */
+#define XLOG_MODULE_DEFINE(name, level)     int8_t xlog_module_level_##name = (level)
+#define XLOG_MODULE_DECLARE(name)           extern int8_t xlog_module_level_##name
+#define xlog_module_set_level(name, level)  (xlog_module_level_##name = (level))
+#define xlog_module_get_level(name)         (xlog_module_level_##name)
+
+#define __xlog_module(name, level, ...)     do { \
+        if((level) <= xlog_module_level_##name) { \
+            xlog(__VA_ARGS__); \
+        } \
+    } while(0)
+
+#define xlog_module_error(name, x, ...)     __xlog_level_error(__xlog_module, name, XLOG_LEVEL_ERROR, \
+                                                               LOG_ERROR "(" #name ")" x, ##__VA_ARGS__)
+#define xlog_module_warn(name, x, ...)      __xlog_level_warn(__xlog_module, name, XLOG_LEVEL_WARN, \
+                                                              LOG_WARN "(" #name ")" x, ##__VA_ARGS__)
+#define xlog_module_message(name, x, ...)   __xlog_level_message(__xlog_module, name, XLOG_LEVEL_MESSAGE, \
+                                                                 LOG_MESSAGE "(" #name ")" x, ##__VA_ARGS__)
+#define xlog_module_info(name, x, ...)      __xlog_level_info(__xlog_module, name, XLOG_LEVEL_INFO, \
+                                                              LOG_INFO "(" #name ")" x, ##__VA_ARGS__)
 
 /*---------- type define ----------*/
 typedef struct {
@@ -89,6 +171,50 @@ extern uint32_t __attribute__((format(printf, 1, 0))) xlog(const char *fmt, ...)
 #define xlog(x, ...)
 #endif
 
+/**
+ * @brief Store a message to the deferred log ring without formatting it. Only the pointer
+ * of fmt, the timestamp and the arguments are stored, a string argument is copied, so fmt
+ * must be a string literal. The message is formatted and printed by the next xlog() or
+ * xlog_flush(), in the order it was logged. Without CONFIG_XLOG_DEFERRED it is the same
+ * as xlog().
+ * @param fmt Format string.
+ *
+ * @retval The bytes stored, 0 if the ring is full and the message is dropped.
+ */
+#if defined(CONFIG_USE_XLOG) && defined(CONFIG_XLOG_DEFERRED)
+extern uint32_t __attribute__((format(printf, 1, 0))) xlog_deferred(const char *fmt, ...);
+#else
+#define xlog_deferred(x, ...)               xlog(x, ##__VA_ARGS__)
+#endif
+
+/**
+ * @brief Print a message from an interrupt, built with CONFIG_XLOG_LOCKFREE. The message
+ * is formatted on the stack and put into the record ring without any lock, it is printed
+ * by the next xlog() or xlog_flush() of a task. get_timestamp() of the ops must be callable
+ * in interrupts. Without CONFIG_XLOG_LOCKFREE the message is discarded.
+ * @param fmt Format string.
+ *
+ * @retval The length put into the record ring, 0 if the ring is full.
+ */
+#if defined(CONFIG_USE_XLOG) && defined(CONFIG_XLOG_LOCKFREE)
+extern uint32_t __attribute__((format(printf, 1, 0))) xlog_isr(const char *fmt, ...);
+#else
+#define xlog_isr(x, ...)
+#endif
+
+/**
+ * @brief Format the messages in the record ring, i.e. the messages of xlog_deferred() and
+ * xlog_isr(), in order and print them to the console, e.g. from the idle task. The number
+ * of the dropped messages is printed as well.
+ *
+ * @retval The number of the messages formatted.
+ */
+#if defined(CONFIG_USE_XLOG) && (defined(CONFIG_XLOG_DEFERRED) || defined(CONFIG_XLOG_LOCKFREE))
+extern uint32_t xlog_flush(void);
+#else
+#define xlog_flush()                        (0)
+#endif
+
 /**
  * @brief Set function used to output log entries. 
  * @param print New function used for output.
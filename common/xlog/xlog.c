@@ -28,6 +28,13 @@
 #include <string.h>
 
 #ifdef CONFIG_USE_XLOG
+#if defined(CONFIG_XLOG_DEFERRED) || defined(CONFIG_XLOG_LOCKFREE)
+#include <stdatomic.h>
+#endif
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+#include <stdlib.h>
+#include <pthread.h>
+#endif
 /*---------- macro ----------*/
 /* log buffer defitions
  */
@@ -41,6 +48,64 @@
 #define __LOG_BUF_LEN                       (1UL << CONFIG_XLOG_BUF_SHIFT)
 #define LOG_BUF_MASK                        (__LOG_BUF_LEN - 1)
 #define LOG_BUF(off)                        (log_buf[(off) & LOG_BUF_MASK])
+/* attributes of the log ring, e.g. __attribute__((section(".fast_ram"))) to
+ * place it in a tightly-coupled ram bank */
+#ifndef CONFIG_XLOG_BUF_ATTRIBUTE
+#define CONFIG_XLOG_BUF_ATTRIBUTE
+#endif
+
+/* Define CONFIG_XLOG_DEFERRED to support xlog_deferred(), which stores the format string
+ * pointer, the timestamp and the raw arguments as a binary record, the text is formatted
+ * later by the next xlog() or xlog_flush(). A record holds at most
+ * CONFIG_XLOG_DEFERRED_RECORD_SIZE bytes, longer arguments are truncated.
+ */
+#ifdef CONFIG_XLOG_DEFERRED
+#ifndef CONFIG_XLOG_DEFERRED_RECORD_SIZE
+#define CONFIG_XLOG_DEFERRED_RECORD_SIZE    (128)
+#endif
+#endif
+
+/* Define CONFIG_XLOG_LOCKFREE to put the messages of xlog() into the record ring as well.
+ * The producers reserve the space with a compare-and-swap and mark the record committed,
+ * so no lock is taken to log and xlog_isr() can be called in interrupts. xlog() formats
+ * the message on its stack in __FORMAT_BUF_LEN bytes, xlog_isr() in
+ * CONFIG_XLOG_ISR_FORMAT_BUF_SIZE bytes. The lock only serializes the drain of the ring
+ * into log_buf and the console.
+ * Define CONFIG_XLOG_THREAD_BUFFERS as well on the POSIX host to give every thread a ring
+ * of its own, the drain merges the rings in timestamp order.
+ */
+#if defined(CONFIG_XLOG_THREAD_BUFFERS) && !defined(CONFIG_XLOG_LOCKFREE)
+#error "CONFIG_XLOG_THREAD_BUFFERS requires CONFIG_XLOG_LOCKFREE"
+#endif
+#ifdef CONFIG_XLOG_LOCKFREE
+#ifndef CONFIG_XLOG_ISR_FORMAT_BUF_SIZE
+#define CONFIG_XLOG_ISR_FORMAT_BUF_SIZE     (128)
+#endif
+#endif
+
+/* The record ring holds 2^CONFIG_XLOG_RECORD_BUF_SHIFT bytes in 64-bit slots. */
+#if defined(CONFIG_XLOG_DEFERRED) || defined(CONFIG_XLOG_LOCKFREE)
+#define XLOG_RECORD_RING
+#ifndef CONFIG_XLOG_RECORD_BUF_SHIFT
+#define CONFIG_XLOG_RECORD_BUF_SHIFT        (11)
+#endif
+#define XLOG_SLOT_SIZE                      (sizeof(uint64_t))
+#define XLOG_SLOTS(bytes)                   (((bytes) + XLOG_SLOT_SIZE - 1) / XLOG_SLOT_SIZE)
+#define XLOG_RECORD_BUF_SLOTS               ((1UL << CONFIG_XLOG_RECORD_BUF_SHIFT) / XLOG_SLOT_SIZE)
+#define XLOG_RECORD_BUF_MASK                (XLOG_RECORD_BUF_SLOTS - 1)
+#define XLOG_HEADER_SLOTS                   XLOG_SLOTS(sizeof(struct xlog_record))
+#ifdef CONFIG_XLOG_DEFERRED
+#define XLOG_RECORD_SLOTS                   XLOG_SLOTS(CONFIG_XLOG_DEFERRED_RECORD_SIZE)
+#endif
+
+#define XLOG_RECORD_PADDING                 (0x01)  /*<< Skips the slots to the end of the ring */
+#define XLOG_RECORD_TIMESTAMP               (0x02)  /*<< utc is valid */
+#define XLOG_RECORD_TRUNCATED               (0x04)  /*<< Some arguments did not fit in the record */
+#define XLOG_RECORD_TEXT                    (0x08)  /*<< A formatted message follows the header */
+#define XLOG_RECORD_COMMITTED               (0x10)  /*<< Written completely by the producer */
+#define XLOG_RECORD_STATE(size, flags)      (((uint32_t)(size) << 16) | (flags))
+#define XLOG_RECORD_SIZE(state)             ((state) >> 16)
+#endif
 
 /* default log level
  */
@@ -57,15 +122,91 @@ struct xlog_describe {
     xlog_ops_t ops;
 };
 
+#ifdef XLOG_RECORD_RING
+/* A record is a header followed by the text of a message, or by one 64-bit slot per
+ * argument of a deferred message, a string argument is copied as a slot of its length
+ * and the slots of its bytes. */
+struct xlog_record {
+    _Atomic uint32_t state;     /*<< Slots and flags, stored last by the producer */
+    const char *fmt;            /*<< The format string of a deferred message */
+    time_t utc;
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+    uint64_t stamp;             /*<< Monotonic nanoseconds, orders the records of all threads */
+#endif
+};
+
+/* Records are reserved by any producer and formatted by the single drain, which zeroes
+ * the slots before releasing them, so only a committed record has a state with
+ * XLOG_RECORD_COMMITTED. */
+struct xlog_ring {
+    uint64_t *pbuf;
+    _Atomic uint32_t head;      /*<< Next slot to be reserved */
+    _Atomic uint32_t tail;      /*<< Next slot to be formatted */
+    _Atomic uint32_t dropped;   /*<< Records dropped because the ring was full */
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+    struct xlog_ring *next;
+    _Atomic bool orphan;        /*<< The thread has exited, freed once it is drained */
+#endif
+};
+#endif
+
+#ifdef CONFIG_XLOG_DEFERRED
+/* The argument types of the conversion specifications. */
+enum xlog_arg_type {
+    XLOG_ARG_NONE = 0,          /*<< "%%" or an unknown conversion, no argument */
+    XLOG_ARG_INT,
+    XLOG_ARG_LONG,
+    XLOG_ARG_LLONG,
+    XLOG_ARG_SIZE,
+    XLOG_ARG_INTMAX,
+    XLOG_ARG_PTRDIFF,
+    XLOG_ARG_DOUBLE,
+    XLOG_ARG_LDOUBLE,
+    XLOG_ARG_PTR,
+    XLOG_ARG_STR,
+    XLOG_ARG_COUNT              /*<< "%n", the pointer is dropped */
+};
+
+struct xlog_spec {
+    enum xlog_arg_type type;
+    bool star_width;
+    bool star_precision;
+};
+#endif
+
 /*---------- variable prototype ----------*/
 /*---------- function prototype ----------*/
+#ifdef XLOG_RECORD_RING
+static uint16_t _record_init(struct xlog_record *header);
+static uint32_t _drain(void);
+#endif
+#ifdef CONFIG_XLOG_LOCKFREE
+static void _try_drain(void);
+static struct xlog_ring *_producer_ring(void);
+static uint32_t _vpush(struct xlog_ring *ring, uint64_t *record, uint32_t slots, bool wait, const char *fmt,
+                      va_list args);
+#endif
 /*---------- variable ----------*/
 static struct xlog_describe _xlog;
 static uint32_t log_start = 0;                      /*<< Index into log_buf: next char to be sent to consoles */
 static uint32_t log_end = 0;                        /*<< Index into log_buf: most-recenrly-written + 1 */
-static char log_buf[__LOG_BUF_LEN];
+static char log_buf[__LOG_BUF_LEN] CONFIG_XLOG_BUF_ATTRIBUTE;
 static bool next_text_line = true;
 static char vprintf_buf[__FORMAT_BUF_LEN];
+#ifdef XLOG_RECORD_RING
+static uint64_t dlog_buf[XLOG_RECORD_BUF_SLOTS] CONFIG_XLOG_BUF_ATTRIBUTE;
+static struct xlog_ring dlog = {.pbuf = dlog_buf};
+#endif
+#ifdef CONFIG_XLOG_LOCKFREE
+static _Atomic bool dlog_draining;                  /*<< Set by the producer draining the rings */
+static _Atomic uint32_t dlog_pushed;                /*<< Counts the messages put by xlog() */
+#endif
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+static _Thread_local struct xlog_ring *thread_ring;
+static struct xlog_ring *thread_rings;              /*<< Rings of all threads, linked under the lock */
+static pthread_key_t thread_ring_key;               /*<< Only used to mark the ring when a thread exits */
+static pthread_once_t thread_ring_once = PTHREAD_ONCE_INIT;
+#endif
 static char log_level_char[] = {
     [0] = 'E',
     [1] = 'W',
@@ -210,17 +351,15 @@ static inline uint32_t _vscnprint(char *buf, uint32_t size, const char *fmt, va_
     return (len >= size) ? (size - 1) : len;
 }
 
-static uint32_t __attribute__((format(printf, 1, 0))) _vprint(const char *fmt, va_list args)
+/* Put the text into the log buffer, printed_len is the length of the text. The timestamp
+ * of a deferred record is passed by ptimestamp, otherwise it is got now if the port supports it.
+ * The caller holds the lock. */
+static uint32_t _emit_text(const char *p, uint32_t printed_len, const time_t *ptimestamp)
 {
-    uint32_t printed_len = 0;
     uint32_t cur_log_level = _xlog.log_level.default_level;
-    char *p = NULL;
     char c = 0;
     uint32_t len = 0;
 
-    __lock();
-    printed_len = _vscnprint(vprintf_buf, sizeof(vprintf_buf), fmt, args);
-    p = vprintf_buf;
     /* Do we have a log level in the string? */
     if(p[0] == '<') {
         c = p[1];
@@ -257,11 +396,15 @@ static uint32_t __attribute__((format(printf, 1, 0))) _vprint(const char *fmt, v
             }
             printed_len += len;
             /* timestamp */
-            if(_xlog.ops.get_timestamp) {
+            if(ptimestamp || _xlog.ops.get_timestamp) {
                 time_t utc = 0;
                 struct tm *ptm = NULL;
                 char time_str[30] = {0};
-                _xlog.ops.get_timestamp(&utc);
+                if(ptimestamp) {
+                    utc = *ptimestamp;
+                } else {
+                    _xlog.ops.get_timestamp(&utc);
+                }
                 ptm = localtime(&utc);
                 snprintf(time_str, sizeof(time_str) - 1, "[%04d-%02d-%02d %02d:%02d:%02d]",
                         ptm->tm_year + 1900, ptm->tm_mon + 1, ptm->tm_mday, ptm->tm_hour, ptm->tm_min, ptm->tm_sec);
@@ -285,6 +428,22 @@ static uint32_t __attribute__((format(printf, 1, 0))) _vprint(const char *fmt, v
             next_text_line = true;
         }
     }
+
+    return printed_len;
+}
+
+#ifndef CONFIG_XLOG_LOCKFREE
+static uint32_t __attribute__((format(printf, 1, 0))) _vprint(const char *fmt, va_list args)
+{
+    uint32_t printed_len = 0;
+
+    __lock();
+#ifdef CONFIG_XLOG_DEFERRED
+    /* the deferred messages logged before this one are printed first */
+    _drain();
+#endif
+    printed_len = _vscnprint(vprintf_buf, sizeof(vprintf_buf), fmt, args);
+    printed_len = _emit_text(vprintf_buf, printed_len, NULL);
     if(_acquire_console()) {
         _print_and_release_console();
     }
@@ -292,19 +451,635 @@ static uint32_t __attribute__((format(printf, 1, 0))) _vprint(const char *fmt, v
 
     return printed_len;
 }
+#endif
 
 uint32_t __attribute__((format(printf, 1, 0))) xlog(const char *fmt, ...)
 {
     va_list args;
     uint32_t len = 0;
+#ifdef CONFIG_XLOG_LOCKFREE
+    uint64_t record[XLOG_HEADER_SLOTS + XLOG_SLOTS(__FORMAT_BUF_LEN)];
+    struct xlog_ring *ring = _producer_ring();
 
+    va_start(args, fmt);
+    len = _vpush(ring, record, sizeof(record) / XLOG_SLOT_SIZE, true, fmt, args);
+    va_end(args);
+    _try_drain();
+#else
     va_start(args, fmt);
     len = _vprint(fmt, args);
     va_end(args);
+#endif
+
+    return len;
+}
+
+#ifdef CONFIG_XLOG_DEFERRED
+/* Parse the conversion specification after a '%', the end of it is returned. */
+static const char *_parse_spec(const char *fmt, struct xlog_spec *pspec)
+{
+    uint32_t longs = 0;
+
+    memset(pspec, 0, sizeof(*pspec));
+    while(*fmt && strchr("-+ #0'", *fmt)) {
+        fmt++;
+    }
+    if(*fmt == '*') {
+        pspec->star_width = true;
+        fmt++;
+    }
+    while(*fmt >= '0' && *fmt <= '9') {
+        fmt++;
+    }
+    if(*fmt == '.') {
+        fmt++;
+        if(*fmt == '*') {
+            pspec->star_precision = true;
+            fmt++;
+        }
+        while(*fmt >= '0' && *fmt <= '9') {
+            fmt++;
+        }
+    }
+    pspec->type = XLOG_ARG_INT;
+    for(; *fmt && strchr("hlLqjzt", *fmt); ++fmt) {
+        switch(*fmt) {
+            case 'l':
+                longs++;
+                pspec->type = (longs > 1) ? XLOG_ARG_LLONG : XLOG_ARG_LONG;
+                break;
+            case 'q':
+            case 'L':
+                longs = 2;
+                pspec->type = XLOG_ARG_LLONG;
+                break;
+            case 'j':
+                pspec->type = XLOG_ARG_INTMAX;
+                break;
+            case 'z':
+                pspec->type = XLOG_ARG_SIZE;
+                break;
+            case 't':
+                pspec->type = XLOG_ARG_PTRDIFF;
+                break;
+            default:
+                break;
+        }
+    }
+    switch(*fmt) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            pspec->type = (longs > 1) ? XLOG_ARG_LDOUBLE : XLOG_ARG_DOUBLE;
+            break;
+        case 'p':
+            pspec->type = XLOG_ARG_PTR;
+            break;
+        case 's':
+            pspec->type = XLOG_ARG_STR;
+            break;
+        case 'n':
+            pspec->type = XLOG_ARG_COUNT;
+            break;
+        default:
+            pspec->type = XLOG_ARG_NONE;
+            pspec->star_width = false;
+            pspec->star_precision = false;
+            break;
+    }
+
+    return (*fmt) ? (fmt + 1) : fmt;
+}
+
+/* Copy the arguments into the slots behind the header, no formatting is done. */
+static uint32_t _encode(uint64_t *record, const char *fmt, va_list args)
+{
+    struct xlog_record *header = (struct xlog_record *)record;
+    struct xlog_spec spec = {0};
+    uint32_t slot = XLOG_HEADER_SLOTS, len = 0;
+    uint16_t flags = _record_init(header);
+    const char *str = NULL;
+    double d = 0;
+
+    header->fmt = fmt;
+    while(*fmt) {
+        if(*fmt++ != '%') {
+            continue;
+        }
+        fmt = _parse_spec(fmt, &spec);
+        /* a string needs its length slot and at least one slot of bytes */
+        if((spec.star_width + spec.star_precision + 1UL + (spec.type == XLOG_ARG_STR)) > (XLOG_RECORD_SLOTS - slot)) {
+            flags |= XLOG_RECORD_TRUNCATED;
+            break;
+        }
+        if(spec.star_width) {
+            record[slot++] = (uint64_t)(int64_t)va_arg(args, int);
+        }
+        if(spec.star_precision) {
+            record[slot++] = (uint64_t)(int64_t)va_arg(args, int);
+        }
+        switch(spec.type) {
+            case XLOG_ARG_INT:
+                record[slot++] = (uint64_t)(int64_t)va_arg(args, int);
+                break;
+            case XLOG_ARG_LONG:
+                record[slot++] = (uint64_t)(int64_t)va_arg(args, long);
+                break;
+            case XLOG_ARG_LLONG:
+                record[slot++] = (uint64_t)va_arg(args, long long);
+                break;
+            case XLOG_ARG_SIZE:
+                record[slot++] = (uint64_t)va_arg(args, size_t);
+                break;
+            case XLOG_ARG_INTMAX:
+                record[slot++] = (uint64_t)va_arg(args, intmax_t);
+                break;
+            case XLOG_ARG_PTRDIFF:
+                record[slot++] = (uint64_t)va_arg(args, ptrdiff_t);
+                break;
+            case XLOG_ARG_DOUBLE:
+            case XLOG_ARG_LDOUBLE:
+                d = (spec.type == XLOG_ARG_DOUBLE) ? va_arg(args, double) : (double)va_arg(args, long double);
+                memcpy(&record[slot++], &d, sizeof(d));
+                break;
+            case XLOG_ARG_PTR:
+            case XLOG_ARG_COUNT:
+                record[slot++] = (uint64_t)(uintptr_t)va_arg(args, void *);
+                break;
+            case XLOG_ARG_STR:
+                /* the string may be gone when the record is formatted, so copy it */
+                str = va_arg(args, const char *);
+                str = str ? str : "(null)";
+                len = strlen(str);
+                if((XLOG_SLOTS(len + 1) + 1) > (XLOG_RECORD_SLOTS - slot)) {
+                    len = (XLOG_RECORD_SLOTS - slot - 1) * XLOG_SLOT_SIZE - 1;
+                    flags |= XLOG_RECORD_TRUNCATED;
+                }
+                record[slot++] = len;
+                memcpy(&record[slot], str, len);
+                ((char *)&record[slot])[len] = '\0';
+                slot += XLOG_SLOTS(len + 1);
+                break;
+            default:
+                break;
+        }
+    }
+    atomic_store_explicit(&header->state, XLOG_RECORD_STATE(slot, flags), memory_order_relaxed);
+
+    return slot;
+}
+
+/* Copy the conversion specification between start and end into spec, the '*' are
+ * replaced by the values of the record and the 'L' is dropped, long double was
+ * stored as double. */
+static void _build_spec(char *spec, uint32_t size, const char *start, const char *end,
+                        const uint64_t *record, uint32_t *pslot)
+{
+    uint32_t len = 0;
+    int32_t value = 0;
+
+    for(; start != end && len < (size - 12); ++start) {
+        if(*start == '*') {
+            value = (int32_t)(int64_t)record[(*pslot)++];
+            if(start[-1] == '.' && value < 0) {
+                /* a negative precision is taken as if it was omitted */
+                len--;
+            } else {
+                len += snprintf(&spec[len], size - len, "%ld", (long)value);
+            }
+        } else if(*start != 'L') {
+            spec[len++] = *start;
+        }
+    }
+    spec[len] = '\0';
+}
+
+/* Format a record of the committed state into buf as vsnprintf() would have done at the
+ * call. A truncated record ends with "..." before its line break. */
+static uint32_t _decode(char *buf, uint32_t size, const uint64_t *record, uint32_t state)
+{
+    const struct xlog_record *header = (const struct xlog_record *)record;
+    struct xlog_spec spec = {0};
+    const char *fmt = header->fmt, *start = NULL;
+    uint32_t slots = XLOG_RECORD_SIZE(state), slot = XLOG_HEADER_SLOTS, len = 0, needed = 0, newline = 0;
+    char spec_str[32] = {0};
+    uint64_t value = 0;
+    double d = 0;
+    int32_t n = 0;
+
+    while(*fmt && len < (size - 1)) {
+        if(*fmt != '%') {
+            buf[len++] = *fmt++;
+            continue;
+        }
+        start = fmt++;
+        fmt = _parse_spec(fmt, &spec);
+        if(spec.type == XLOG_ARG_NONE) {
+            if(fmt[-1] == '%') {
+                buf[len++] = '%';
+            }
+            continue;
+        }
+        needed = spec.star_width + spec.star_precision + 1UL;
+        if(spec.type == XLOG_ARG_STR) {
+            needed++;
+        }
+        if(needed > (slots - slot)) {
+            /* truncated record, keep the text and drop the conversions */
+            continue;
+        }
+        _build_spec(spec_str, sizeof(spec_str), start, fmt, record, &slot);
+        value = record[slot++];
+        switch(spec.type) {
+            case XLOG_ARG_INT:
+                n = snprintf(&buf[len], size - len, spec_str, (int)value);
+                break;
+            case XLOG_ARG_LONG:
+                n = snprintf(&buf[len], size - len, spec_str, (long)value);
+                break;
+            case XLOG_ARG_LLONG:
+                n = snprintf(&buf[len], size - len, spec_str, (long long)value);
+                break;
+            case XLOG_ARG_SIZE:
+                n = snprintf(&buf[len], size - len, spec_str, (size_t)value);
+                break;
+            case XLOG_ARG_INTMAX:
+                n = snprintf(&buf[len], size - len, spec_str, (intmax_t)value);
+                break;
+            case XLOG_ARG_PTRDIFF:
+                n = snprintf(&buf[len], size - len, spec_str, (ptrdiff_t)value);
+                break;
+            case XLOG_ARG_DOUBLE:
+            case XLOG_ARG_LDOUBLE:
+                memcpy(&d, &value, sizeof(d));
+                n = snprintf(&buf[len], size - len, spec_str, d);
+                break;
+            case XLOG_ARG_PTR:
+                n = snprintf(&buf[len], size - len, spec_str, (void *)(uintptr_t)value);
+                break;
+            case XLOG_ARG_STR:
+                n = snprintf(&buf[len], size - len, spec_str, (const char *)&record[slot]);
+                slot += XLOG_SLOTS(value + 1);
+                break;
+            default:
+                n = 0;
+                break;
+        }
+        len += (n > 0) ? (uint32_t)n : 0;
+    }
+    len = (len >= size) ? (size - 1) : len;
+    if(state & XLOG_RECORD_TRUNCATED) {
+        newline = (len && buf[len - 1] == '\n') ? 1 : 0;
+        len -= newline;
+        len = (len > (size - 5)) ? (size - 5) : len;
+        memcpy(&buf[len], "...\n", 4);
+        len += 3 + newline;
+    }
+    buf[len] = '\0';
 
     return len;
 }
 
+#endif
+
+#ifdef XLOG_RECORD_RING
+/* Fill the header of a record built on the stack, the flags of the timestamp are returned. */
+static uint16_t _record_init(struct xlog_record *header)
+{
+    uint16_t flags = 0;
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    header->stamp = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+    header->fmt = NULL;
+    header->utc = 0;
+    if(_xlog.ops.get_timestamp) {
+        _xlog.ops.get_timestamp(&header->utc);
+        flags |= XLOG_RECORD_TIMESTAMP;
+    }
+
+    return flags;
+}
+
+/* Reserve the slots of a record, copy it and commit it. A record never wraps, the slots
+ * to the end of the ring are skipped by a padding record reserved together with it.
+ * Without CONFIG_XLOG_LOCKFREE the record is reserved and committed under the lock, the
+ * drain before a locked xlog() would stop at a record reserved but not yet committed and
+ * print the message ahead of the older deferred ones otherwise. If the ring is full,
+ * false is returned and the caller counts the record as dropped. */
+static bool _ring_put(struct xlog_ring *ring, const uint64_t *record, uint32_t slots)
+{
+    const struct xlog_record *header = (const struct xlog_record *)record;
+    struct xlog_record *padding = NULL;
+    uint32_t head = 0, offset = 0, to_end = 0, needed = 0;
+    uint32_t state = atomic_load_explicit(&header->state, memory_order_relaxed);
+
+#ifndef CONFIG_XLOG_LOCKFREE
+    __lock();
+#endif
+    head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    do {
+        offset = head & XLOG_RECORD_BUF_MASK;
+        to_end = XLOG_RECORD_BUF_SLOTS - offset;
+        needed = slots + ((to_end < slots) ? to_end : 0);
+        if((XLOG_RECORD_BUF_SLOTS - (head - atomic_load_explicit(&ring->tail, memory_order_acquire))) < needed) {
+            needed = 0;
+            break;
+        }
+#ifdef CONFIG_XLOG_LOCKFREE
+    } while(!atomic_compare_exchange_weak_explicit(&ring->head, &head, head + needed,
+                                                   memory_order_relaxed, memory_order_relaxed));
+#else
+        atomic_store_explicit(&ring->head, head + needed, memory_order_relaxed);
+    } while(0);
+#endif
+    if(needed) {
+        if(to_end < slots) {
+            padding = (struct xlog_record *)&ring->pbuf[offset];
+            atomic_store_explicit(&padding->state,
+                                  XLOG_RECORD_STATE(to_end, XLOG_RECORD_PADDING | XLOG_RECORD_COMMITTED),
+                                  memory_order_release);
+            offset = 0;
+        }
+        /* the state is stored last, the drain sees the whole record once it is committed */
+        memcpy((uint8_t *)&ring->pbuf[offset] + sizeof(uint32_t), (const uint8_t *)record + sizeof(uint32_t),
+               slots * XLOG_SLOT_SIZE - sizeof(uint32_t));
+        atomic_store_explicit(&((struct xlog_record *)&ring->pbuf[offset])->state, state | XLOG_RECORD_COMMITTED,
+                              memory_order_release);
+    }
+#ifndef CONFIG_XLOG_LOCKFREE
+    __unlock();
+#endif
+
+    return (needed != 0);
+}
+
+/* Zero the slots of the first record, so they can not be taken for a committed record
+ * when they are reserved again, and release them to the producers. */
+static void _ring_release(struct xlog_ring *ring, uint32_t slots)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    memset(&ring->pbuf[tail & XLOG_RECORD_BUF_MASK], 0, slots * XLOG_SLOT_SIZE);
+    atomic_store_explicit(&ring->tail, tail + slots, memory_order_release);
+}
+
+/* Get the first committed record of the ring, the padding records are released on the way. */
+static struct xlog_record *_ring_peek(struct xlog_ring *ring)
+{
+    struct xlog_record *header = NULL;
+    uint32_t state = 0;
+
+    for(;;) {
+        header = (struct xlog_record *)&ring->pbuf[atomic_load_explicit(&ring->tail, memory_order_relaxed) &
+                                                   XLOG_RECORD_BUF_MASK];
+        state = atomic_load_explicit(&header->state, memory_order_acquire);
+        if(!(state & XLOG_RECORD_COMMITTED)) {
+            header = NULL;
+            break;
+        }
+        if(!(state & XLOG_RECORD_PADDING)) {
+            break;
+        }
+        _ring_release(ring, XLOG_RECORD_SIZE(state));
+    }
+
+    return header;
+}
+
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+static void _thread_ring_destructor(void *arg)
+{
+    atomic_store_explicit(&((struct xlog_ring *)arg)->orphan, true, memory_order_release);
+}
+
+static void _thread_ring_key_create(void)
+{
+    pthread_key_create(&thread_ring_key, _thread_ring_destructor);
+}
+
+/* The ring of the calling thread, it is allocated on the first message of the thread.
+ * xlog sits below the heap module, so the C library allocates it. */
+static struct xlog_ring *_producer_ring(void)
+{
+    struct xlog_ring *ring = thread_ring;
+
+    if(!ring) {
+        ring = (struct xlog_ring *)calloc(1, sizeof(struct xlog_ring) + sizeof(dlog_buf));
+        if(ring) {
+            ring->pbuf = (uint64_t *)(ring + 1);
+            pthread_once(&thread_ring_once, _thread_ring_key_create);
+            pthread_setspecific(thread_ring_key, ring);
+            __lock();
+            ring->next = thread_rings;
+            thread_rings = ring;
+            __unlock();
+        } else {
+            ring = &dlog;
+        }
+        thread_ring = ring;
+    }
+
+    return ring;
+}
+
+/* Free the rings of the exited threads once they are drained, the caller holds the lock. */
+static void _thread_rings_collect(void)
+{
+    struct xlog_ring **pprev = &thread_rings, *ring = NULL;
+
+    while(NULL != (ring = *pprev)) {
+        if(atomic_load_explicit(&ring->orphan, memory_order_acquire) &&
+           atomic_load_explicit(&ring->head, memory_order_relaxed) ==
+           atomic_load_explicit(&ring->tail, memory_order_relaxed)) {
+            *pprev = ring->next;
+            free(ring);
+        } else {
+            pprev = &ring->next;
+        }
+    }
+}
+#else
+static inline struct xlog_ring *_producer_ring(void)
+{
+    return &dlog;
+}
+#endif
+
+/* The record to be formatted next, with CONFIG_XLOG_THREAD_BUFFERS the oldest first
+ * record of all rings. */
+static struct xlog_record *_drain_next(struct xlog_ring **pring)
+{
+    struct xlog_record *header = _ring_peek(&dlog);
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+    struct xlog_record *candidate = NULL;
+#endif
+
+    *pring = &dlog;
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+    for(struct xlog_ring *ring = thread_rings; ring; ring = ring->next) {
+        candidate = _ring_peek(ring);
+        if(candidate && (!header || candidate->stamp < header->stamp)) {
+            header = candidate;
+            *pring = ring;
+        }
+    }
+#endif
+
+    return header;
+}
+
+/* Format the committed records into log_buf and print them, the caller holds the lock.
+ * Every record is printed before the next one is formatted, a batch longer than log_buf
+ * would overwrite its own oldest text otherwise. */
+static uint32_t _drain(void)
+{
+    struct xlog_ring *ring = NULL;
+    struct xlog_record *header = NULL;
+    uint32_t state = 0, printed_len = 0, dropped = 0, count = 0;
+    const time_t *ptimestamp = NULL;
+
+    while(NULL != (header = _drain_next(&ring))) {
+        state = atomic_load_explicit(&header->state, memory_order_relaxed);
+        ptimestamp = (state & XLOG_RECORD_TIMESTAMP) ? &header->utc : NULL;
+        if(state & XLOG_RECORD_TEXT) {
+            _emit_text((const char *)((const uint64_t *)header + XLOG_HEADER_SLOTS),
+                       strlen((const char *)((const uint64_t *)header + XLOG_HEADER_SLOTS)), ptimestamp);
+        }
+#ifdef CONFIG_XLOG_DEFERRED
+        else {
+            printed_len = _decode(vprintf_buf, sizeof(vprintf_buf), (const uint64_t *)header, state);
+            _emit_text(vprintf_buf, printed_len, ptimestamp);
+        }
+#endif
+        _ring_release(ring, XLOG_RECORD_SIZE(state));
+        if(_acquire_console()) {
+            _print_and_release_console();
+        }
+        count++;
+    }
+    dropped = atomic_exchange_explicit(&dlog.dropped, 0, memory_order_relaxed);
+#ifdef CONFIG_XLOG_THREAD_BUFFERS
+    for(ring = thread_rings; ring; ring = ring->next) {
+        dropped += atomic_exchange_explicit(&ring->dropped, 0, memory_order_relaxed);
+    }
+    _thread_rings_collect();
+#endif
+    if(dropped) {
+        printed_len = snprintf(vprintf_buf, sizeof(vprintf_buf), LOG_WARN "%lu logs dropped by the record ring\n",
+                               (unsigned long)dropped);
+        _emit_text(vprintf_buf, printed_len, NULL);
+        if(_acquire_console()) {
+            _print_and_release_console();
+        }
+    }
+
+    return count;
+}
+#endif
+
+#ifdef CONFIG_XLOG_LOCKFREE
+/* Format a message into a text record of slots on the stack of the caller and put it
+ * into the ring. If the ring is full and the caller can wait, the rings are drained under
+ * the lock as the locked xlog() would do, so the message is only dropped while a record
+ * reserved by a preempted producer holds the ring. */
+static uint32_t __attribute__((format(printf, 5, 0))) _vpush(struct xlog_ring *ring, uint64_t *record, uint32_t slots,
+                                                              bool wait, const char *fmt, va_list args)
+{
+    struct xlog_record *header = (struct xlog_record *)record;
+    uint16_t flags = _record_init(header) | XLOG_RECORD_TEXT;
+    uint32_t len = 0;
+    bool retval = false;
+
+    len = _vscnprint((char *)&record[XLOG_HEADER_SLOTS], (slots - XLOG_HEADER_SLOTS) * XLOG_SLOT_SIZE, fmt, args);
+    slots = XLOG_HEADER_SLOTS + XLOG_SLOTS(len + 1);
+    atomic_store_explicit(&header->state, XLOG_RECORD_STATE(slots, flags), memory_order_relaxed);
+    retval = _ring_put(ring, record, slots);
+    if(!retval && wait) {
+        __lock();
+        _drain();
+        __unlock();
+        retval = _ring_put(ring, record, slots);
+    }
+    if(!retval) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        len = 0;
+    }
+
+    return len;
+}
+
+/* Drain the rings unless another producer is doing it. The drainer reads the count of
+ * pushed messages again after it has cleared the flag and drains once more if it has
+ * changed, a message pushed meanwhile would be left behind otherwise. Both are
+ * sequentially consistent, so either the pusher gets the flag or the drainer sees the
+ * new count. */
+static void _try_drain(void)
+{
+    uint32_t pushed = 0;
+
+    atomic_fetch_add(&dlog_pushed, 1);
+    while(!atomic_exchange(&dlog_draining, true)) {
+        pushed = atomic_load(&dlog_pushed);
+        __lock();
+        _drain();
+        __unlock();
+        atomic_store(&dlog_draining, false);
+        if(atomic_load(&dlog_pushed) == pushed) {
+            break;
+        }
+    }
+}
+
+uint32_t __attribute__((format(printf, 1, 0))) xlog_isr(const char *fmt, ...)
+{
+    uint64_t record[XLOG_HEADER_SLOTS + XLOG_SLOTS(CONFIG_XLOG_ISR_FORMAT_BUF_SIZE)];
+    va_list args;
+    uint32_t len = 0;
+
+    va_start(args, fmt);
+    len = _vpush(&dlog, record, sizeof(record) / XLOG_SLOT_SIZE, false, fmt, args);
+    va_end(args);
+
+    return len;
+}
+#endif
+
+#ifdef CONFIG_XLOG_DEFERRED
+uint32_t __attribute__((format(printf, 1, 0))) xlog_deferred(const char *fmt, ...)
+{
+    uint64_t record[XLOG_RECORD_SLOTS];
+    struct xlog_ring *ring = _producer_ring();
+    va_list args;
+    uint32_t slots = 0;
+
+    va_start(args, fmt);
+    slots = _encode(record, fmt, args);
+    va_end(args);
+    if(!_ring_put(ring, record, slots)) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        slots = 0;
+    }
+
+    return (slots * XLOG_SLOT_SIZE);
+}
+#endif
+
+#ifdef XLOG_RECORD_RING
+uint32_t xlog_flush(void)
+{
+    uint32_t count = 0;
+
+    __lock();
+    count = _drain();
+    __unlock();
+
+    return count;
+}
+#endif
+
 xlog_print_func_t xlog_set_print_func(xlog_print_func_t print)
 {
     xlog_print_func_t old_print = _xlog.ops.print;
@@ -336,6 +1111,12 @@ void xlog_init(xlog_ops_t *ops)
     log_start = 0;
     log_end = 0;
     next_text_line = true;
+#ifdef XLOG_RECORD_RING
+    memset(dlog_buf, 0, sizeof(dlog_buf));
+    atomic_store(&dlog.head, 0);
+    atomic_store(&dlog.tail, 0);
+    atomic_store(&dlog.dropped, 0);
+#endif
     _xlog.log_level.default_level = DEFAULT_MESSAGE_LOG_LEVEL;
     _xlog.log_level.console_level = DEFAULT_CONSOLE_LOG_LEVEL;
     _xlog.hide_log_type = true;
@@ -76,6 +76,24 @@ extern "C"
  */
 #define IOCTL_TIMER_DISABLE                         (IOCTL_USER_START + 0x04)
 
+/**
+ * @brief Get the current value of the free running counter.
+ * @param Args is a pointer of the buffer to store the counter value.
+ * @retval If the args is null or the bsp does not support the counter,
+ *         the interface will return CY_E_WRONG_ARGS, otherwise, return CY_EOK.
+ */
+#define IOCTL_TIMER_GET_COUNTER                     (IOCTL_USER_START + 0x05)
+
+/**
+ * @brief Set the compare channel, the irq server callback function is called
+ *        when the counter reaches the compare value.
+ * @param Args is a pointer of the compare value.
+ * @retval If the args is null or the bsp does not support the compare channel,
+ *         the interface will return CY_E_WRONG_ARGS, if the bsp set the compare
+ *         channel failed, return CY_ERROR, otherwise, return CY_EOK.
+ */
+#define IOCTL_TIMER_SET_COMPARE                     (IOCTL_USER_START + 0x06)
+
 /*---------- type define ----------*/
 typedef int32_t (*timer_irq_handler_fn)(uint32_t irq_handler, void *args, uint32_t len);
 
@@ -86,6 +104,8 @@ typedef struct {
         void (*deinit)(void);
         bool (*enable)(bool ctrl);
         timer_irq_handler_fn irq_handler;
+        uint32_t (*get_counter)(void);
+        bool (*set_compare)(uint32_t compare);
     } ops;
 } timer_describe_t;
 
@@ -42,6 +42,8 @@ static int32_t __ioctl_set_freq(timer_describe_t *pdesc, void *args);
 static int32_t __ioctl_set_irq(timer_describe_t *pdesc, void *args);
 static int32_t __ioctl_enable(timer_describe_t *pdesc, void *args);
 static int32_t __ioctl_disable(timer_describe_t *pdesc, void *args);
+static int32_t __ioctl_get_counter(timer_describe_t *pdesc, void *args);
+static int32_t __ioctl_set_compare(timer_describe_t *pdesc, void *args);
 
 /*---------- type define ----------*/
 typedef int32_t (*ioctl_cb_func_t)(timer_describe_t *pdesc, void *args);
@@ -57,7 +59,9 @@ static ioctl_cb_t ioctl_cb_array[] = {
     {IOCTL_TIMER_SET_FREQ, __ioctl_set_freq},
     {IOCTL_TIMER_SET_IRQ_HANDLER, __ioctl_set_irq},
     {IOCTL_TIMER_ENABLE, __ioctl_enable},
-    {IOCTL_TIMER_DISABLE, __ioctl_disable}
+    {IOCTL_TIMER_DISABLE, __ioctl_disable},
+    {IOCTL_TIMER_GET_COUNTER, __ioctl_get_counter},
+    {IOCTL_TIMER_SET_COMPARE, __ioctl_set_compare}
 };
 
 /*---------- function ----------*/
@@ -169,6 +173,38 @@ static int32_t __ioctl_disable(timer_describe_t *pdesc, void *args)
     return retval;
 }
 
+static int32_t __ioctl_get_counter(timer_describe_t *pdesc, void *args)
+{
+    int32_t retval = CY_E_WRONG_ARGS;
+    uint32_t *counter = (uint32_t *)args;
+
+    if(!args || !pdesc->ops.get_counter) {
+        xlog_tag_error(TAG, "Args format error or bsp not support, can not get timer counter\n");
+    } else {
+        *counter = pdesc->ops.get_counter();
+        retval = CY_EOK;
+    }
+
+    return retval;
+}
+
+static int32_t __ioctl_set_compare(timer_describe_t *pdesc, void *args)
+{
+    int32_t retval = CY_E_WRONG_ARGS;
+    uint32_t *compare = (uint32_t *)args;
+
+    if(!args || !pdesc->ops.set_compare) {
+        xlog_tag_error(TAG, "Args format error or bsp not support, can not set timer compare\n");
+    } else {
+        retval = CY_ERROR;
+        if(pdesc->ops.set_compare(*compare)) {
+            retval = CY_EOK;
+        }
+    }
+
+    return retval;
+}
+
 static ioctl_cb_func_t __ioctl_cb_func_find(uint32_t ioctl_cmd)
 {
     ioctl_cb_func_t cb = NULL;
@@ -0,0 +1,112 @@
+/**
+ * @file tools/host/heap_aligned_bench.c
+ *
+ * Copyright (C) 2024
+ *
+ * heap_aligned_bench.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note fragmentation benchmark of heap_malloc_aligned() against over-allocating with
+ * heap_malloc() and rounding the pointer up. Aligned DMA buffers and small unaligned
+ * blocks are interleaved until the heap is full, then the small blocks are released
+ * and the free space left around the DMA buffers is reported.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define BLOCK_COUNT                         (4096)
+
+/*---------- type define ----------*/
+typedef void *(*aligned_alloc_t)(size_t size, size_t alignment);
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+pthread_mutex_t heap_host_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void *_buffers[BLOCK_COUNT];
+static void *_smalls[BLOCK_COUNT];
+
+/*---------- function ----------*/
+/* The block is kept by its base pointer, the aligned address is what the DMA would use. */
+static void *_over_allocate(size_t size, size_t alignment)
+{
+    return heap_malloc(size + alignment - 1);
+}
+
+static double _seconds(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static int _run(const char *name, aligned_alloc_t alloc, size_t alignment)
+{
+    struct heap_stats stats = {0};
+    unsigned int seed = 1;
+    uint32_t count = 0;
+    size_t initial = heap_get_free_remaining_size();
+    double elapsed = 0;
+
+    for(count = 0; count < BLOCK_COUNT; ++count) {
+        _smalls[count] = heap_malloc(24 + (size_t)rand_r(&seed) % 176);
+        elapsed -= _seconds();
+        _buffers[count] = alloc(64 + (size_t)rand_r(&seed) % 960, alignment);
+        elapsed += _seconds();
+        if(!_smalls[count] || !_buffers[count]) {
+            break;
+        }
+    }
+    for(uint32_t i = 0; i <= count && i < BLOCK_COUNT; ++i) {
+        heap_free(_smalls[i]);
+        _smalls[i] = NULL;
+    }
+    heap_get_stats(HEAP_REGION_ANY, &stats);
+    printf("%-10s align %4zu: %4u buffers, %6.1f ns/alloc, %7zu free in %4u blocks, largest %7zu, "
+           "fragmentation %3u%%\n", name, alignment, count, elapsed * 1e9 / (count ? count : 1),
+           stats.free_bytes, stats.free_block_count, stats.largest_free_block, stats.fragmentation);
+    for(uint32_t i = 0; i <= count && i < BLOCK_COUNT; ++i) {
+        heap_free(_buffers[i]);
+        _buffers[i] = NULL;
+    }
+
+    return (heap_get_free_remaining_size() == initial) ? 0 : 1;
+}
+
+int main(void)
+{
+    int retval = 0;
+
+    heap_free(heap_malloc(1));
+    printf("engine %s, %lu bytes\n", HEAP_HOST_ENGINE, (unsigned long)CONFIG_HEAP_TOTAL_SIZE);
+    for(size_t alignment = 64; alignment <= 1024; alignment <<= 2) {
+        retval |= _run("aligned", heap_malloc_aligned, alignment);
+        retval |= _run("over-alloc", _over_allocate, alignment);
+    }
+    if(retval) {
+        printf("FAIL: the heap is not whole after a run\n");
+    }
+
+    return retval;
+}
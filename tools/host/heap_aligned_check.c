@@ -0,0 +1,120 @@
+/**
+ * @file tools/host/heap_aligned_check.c
+ *
+ * Copyright (C) 2024
+ *
+ * heap_aligned_check.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note randomized mix of heap_malloc(), heap_malloc_aligned() and heap_free(), every block
+ * is checked for its alignment and its content, the heap must be whole again at the end
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*---------- macro ----------*/
+#define SLOT_COUNT                          (500)
+#define OPERATION_COUNT                     (500000)
+#define MAX_SIZE                            (300)
+#define MAX_ALIGNMENT_SHIFT                 (12)
+
+/*---------- type define ----------*/
+struct slot {
+    uint8_t *ptr;
+    size_t size;
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+pthread_mutex_t heap_host_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct slot _slots[SLOT_COUNT];
+
+/*---------- function ----------*/
+static bool _content_is_intact(struct slot *pslot, uint8_t pattern)
+{
+    bool retval = true;
+
+    for(size_t i = 0; i < pslot->size && retval; ++i) {
+        retval = (pattern == pslot->ptr[i]);
+    }
+
+    return retval;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int seed = (argc > 1) ? (unsigned int)atoi(argv[1]) : 1;
+    uint32_t aligned = 0, failed = 0, k = 0;
+    size_t initial = 0, alignment = 0;
+    struct slot *pslot = NULL;
+    int retval = 0;
+
+    heap_free(heap_malloc(1));
+    initial = heap_get_free_remaining_size();
+    for(uint32_t i = 0; i < OPERATION_COUNT && !retval; ++i) {
+        k = (uint32_t)rand_r(&seed) % SLOT_COUNT;
+        pslot = &_slots[k];
+        if(pslot->ptr) {
+            if(!_content_is_intact(pslot, (uint8_t)k)) {
+                printf("FAIL: block %p of %zu bytes is corrupted\n", (void *)pslot->ptr, pslot->size);
+                retval = 1;
+            }
+            heap_free(pslot->ptr);
+            pslot->ptr = NULL;
+            continue;
+        }
+        pslot->size = 1 + (size_t)rand_r(&seed) % MAX_SIZE;
+        alignment = 0;
+        if(rand_r(&seed) & 1) {
+            alignment = ((size_t)1) << ((uint32_t)rand_r(&seed) % (MAX_ALIGNMENT_SHIFT + 1));
+            pslot->ptr = (uint8_t *)heap_malloc_aligned(pslot->size, alignment);
+            aligned++;
+        } else {
+            pslot->ptr = (uint8_t *)heap_malloc(pslot->size);
+        }
+        if(!pslot->ptr) {
+            failed++;
+        } else if(alignment && ((uintptr_t)pslot->ptr % alignment)) {
+            printf("FAIL: %p is not aligned to %zu\n", (void *)pslot->ptr, alignment);
+            retval = 1;
+        } else if(heap_usable_size(pslot->ptr) < pslot->size) {
+            printf("FAIL: %p holds %zu of %zu bytes\n", (void *)pslot->ptr, heap_usable_size(pslot->ptr),
+                   pslot->size);
+            retval = 1;
+        } else {
+            memset(pslot->ptr, (int)k, pslot->size);
+        }
+    }
+    for(k = 0; k < SLOT_COUNT; ++k) {
+        heap_free(_slots[k].ptr);
+        _slots[k].ptr = NULL;
+    }
+    if(heap_get_free_remaining_size() != initial) {
+        printf("FAIL: %zu of %zu bytes free after all blocks were released\n", heap_get_free_remaining_size(),
+               initial);
+        retval = 1;
+    }
+    printf("%s: %u operations, %u aligned, %u failed for lack of memory\n", retval ? "FAIL" : "OK",
+           OPERATION_COUNT, aligned, failed);
+
+    return retval;
+}
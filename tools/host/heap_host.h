@@ -0,0 +1,51 @@
+/**
+ * @file tools/host/heap_host.h
+ *
+ * Copyright (C) 2024
+ *
+ * heap_host.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note CONFIG_HEAP_FILE of the host builds of common/heap, the heap is locked by a mutex
+ *
+ * @encoding utf-8
+ */
+#ifndef __HEAP_HOST_H
+#define __HEAP_HOST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <pthread.h>
+
+/*---------- macro ----------*/
+#ifndef CONFIG_HEAP_TOTAL_SIZE
+#define CONFIG_HEAP_TOTAL_SIZE              (16UL * 1024UL * 1024UL)
+#endif
+#define CONFIG_HEAP_LOCK()                  pthread_mutex_lock(&heap_host_mutex)
+#define CONFIG_HEAP_UNLOCK()                pthread_mutex_unlock(&heap_host_mutex)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/* Defined by the program using the heap. */
+extern pthread_mutex_t heap_host_mutex;
+
+/*---------- function prototype ----------*/
+#ifdef __cplusplus
+}
+#endif
+#endif /* __HEAP_HOST_H */
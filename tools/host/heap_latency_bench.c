@@ -0,0 +1,164 @@
+/**
+ * @file tools/host/heap_latency_bench.c
+ *
+ * Copyright (C) 2024
+ *
+ * heap_latency_bench.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note latency distribution of heap_malloc() and heap_free(), built once per engine.
+ * "churn" is a long random mix of sizes, "fragmented" allocates a block larger than any
+ * of thousands of holes left between live blocks, the worst case of a first fit walk.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define SLOT_COUNT                          (2000)
+#define CHURN_COUNT                         (200000)
+#define HOLE_COUNT                          (4096)
+#define FRAGMENTED_COUNT                    (2000)
+
+/*---------- type define ----------*/
+struct latency {
+    uint32_t count;
+    uint32_t samples[CHURN_COUNT];
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+pthread_mutex_t heap_host_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct latency _malloc_latency, _free_latency;
+static void *_slots[SLOT_COUNT];
+static void *_holes[HOLE_COUNT * 2];
+
+/*---------- function ----------*/
+static uint64_t _now_ns(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+static void *_timed_malloc(size_t size)
+{
+    uint64_t start = _now_ns();
+    void *ptr = heap_malloc(size);
+
+    _malloc_latency.samples[_malloc_latency.count++] = (uint32_t)(_now_ns() - start);
+
+    return ptr;
+}
+
+static void _timed_free(void *ptr)
+{
+    uint64_t start = _now_ns();
+
+    heap_free(ptr);
+    _free_latency.samples[_free_latency.count++] = (uint32_t)(_now_ns() - start);
+}
+
+static int _compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static void _report(const char *phase, const char *op, struct latency *platency)
+{
+    uint32_t n = platency->count;
+
+    if(n) {
+        qsort(platency->samples, n, sizeof(platency->samples[0]), _compare);
+        printf("%-10s %-6s %7u ops, p50 %6u ns, p99 %6u ns, p99.9 %6u ns, max %7u ns\n", phase, op, n,
+               platency->samples[n / 2], platency->samples[(uint64_t)n * 99 / 100],
+               platency->samples[(uint64_t)n * 999 / 1000], platency->samples[n - 1]);
+    }
+    platency->count = 0;
+}
+
+static void _churn(void)
+{
+    unsigned int seed = 1;
+    uint32_t k = 0;
+
+    for(uint32_t i = 0; i < CHURN_COUNT; ++i) {
+        k = (uint32_t)rand_r(&seed) % SLOT_COUNT;
+        if(_slots[k]) {
+            _timed_free(_slots[k]);
+            _slots[k] = NULL;
+        } else {
+            _slots[k] = _timed_malloc(16 + (size_t)rand_r(&seed) % 1024);
+        }
+    }
+    _report("churn", "malloc", &_malloc_latency);
+    _report("churn", "free", &_free_latency);
+    for(k = 0; k < SLOT_COUNT; ++k) {
+        heap_free(_slots[k]);
+        _slots[k] = NULL;
+    }
+}
+
+static void _fragmented(void)
+{
+    void *ptr = NULL;
+
+    /* every other block is released, the holes can not merge */
+    for(uint32_t i = 0; i < HOLE_COUNT * 2; ++i) {
+        _holes[i] = heap_malloc(32);
+    }
+    for(uint32_t i = 0; i < HOLE_COUNT * 2; i += 2) {
+        heap_free(_holes[i]);
+        _holes[i] = NULL;
+    }
+    for(uint32_t i = 0; i < FRAGMENTED_COUNT; ++i) {
+        ptr = _timed_malloc(256);
+        _timed_free(ptr);
+    }
+    _report("fragmented", "malloc", &_malloc_latency);
+    _report("fragmented", "free", &_free_latency);
+    for(uint32_t i = 1; i < HOLE_COUNT * 2; i += 2) {
+        heap_free(_holes[i]);
+        _holes[i] = NULL;
+    }
+}
+
+int main(void)
+{
+    size_t initial = 0;
+
+    heap_free(heap_malloc(1));
+    initial = heap_get_free_remaining_size();
+    printf("engine %s, %lu bytes\n", HEAP_HOST_ENGINE, (unsigned long)CONFIG_HEAP_TOTAL_SIZE);
+    _churn();
+    _fragmented();
+    if(heap_get_free_remaining_size() != initial) {
+        printf("FAIL: %zu of %zu bytes free at the end\n", heap_get_free_remaining_size(), initial);
+        return 1;
+    }
+
+    return 0;
+}
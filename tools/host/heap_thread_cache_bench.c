@@ -0,0 +1,192 @@
+/**
+ * @file tools/host/heap_thread_cache_bench.c
+ *
+ * Copyright (C) 2024
+ *
+ * heap_thread_cache_bench.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note scaling of heap_malloc()/heap_free() from 1 to N threads, built with and without
+ * CONFIG_HEAP_THREAD_CACHE. Every thread frees a block from a TLS destructor which runs
+ * after the destructor of the thread cache, the heap must be whole again after the
+ * threads have exited. The statistics must count every heap_malloc() and heap_free(),
+ * and the magazines must not take aligned blocks or blocks of another region.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "heap.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define SLOT_COUNT                          (64)
+#define OPERATION_COUNT                     (1000000)
+#define MAX_SIZE                            (2048)
+#define REGION_SIZE                         (16 * 1024)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+pthread_mutex_t heap_host_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t _late_key;
+static volatile uint32_t _corrupted;
+static _Atomic uint32_t _allocated;
+static uint8_t _region[REGION_SIZE];
+
+/*---------- function ----------*/
+static void _late_free(void *ptr)
+{
+    heap_free(ptr);
+}
+
+static void *_worker(void *arg)
+{
+    unsigned int seed = (unsigned int)(uintptr_t)arg;
+    void *slots[SLOT_COUNT] = {0};
+    uint32_t k = 0, allocated = 0;
+    size_t size = 0;
+
+    for(uint32_t i = 0; i < OPERATION_COUNT; ++i) {
+        k = (uint32_t)rand_r(&seed) % SLOT_COUNT;
+        if(slots[k]) {
+            if(*(uint8_t *)slots[k] != (uint8_t)k) {
+                _corrupted++;
+            }
+            heap_free(slots[k]);
+            slots[k] = NULL;
+        } else {
+            size = 1 + (size_t)rand_r(&seed) % MAX_SIZE;
+            slots[k] = heap_malloc(size);
+            if(slots[k]) {
+                memset(slots[k], (int)k, size);
+                allocated++;
+            }
+        }
+    }
+    for(k = 0; k < SLOT_COUNT; ++k) {
+        heap_free(slots[k]);
+    }
+    slots[0] = heap_malloc(64);
+    if(slots[0]) {
+        allocated++;
+    }
+    pthread_setspecific(_late_key, slots[0]);
+    atomic_fetch_add(&_allocated, allocated);
+
+    return NULL;
+}
+
+/* Aligned blocks and blocks of another region go back to their region at once. */
+static bool _bypass_is_right(int32_t region)
+{
+    size_t free_bytes = 0, region_free_bytes = 0;
+    void *ptr = NULL;
+    bool retval = true;
+
+    free_bytes = heap_get_region_free_remaining_size(0);
+    ptr = heap_malloc_aligned(64, 256);
+    heap_free(ptr);
+    if(!ptr || heap_get_region_free_remaining_size(0) != free_bytes) {
+        printf("FAIL: an aligned block was not returned to the heap\n");
+        retval = false;
+    }
+    region_free_bytes = heap_get_region_free_remaining_size((uint32_t)region);
+    ptr = heap_malloc_in(HEAP_REGION_MASK(region), 64);
+    heap_free(ptr);
+    if(!ptr || heap_get_region_free_remaining_size((uint32_t)region) != region_free_bytes) {
+        printf("FAIL: a block of region %d was not returned to its region\n", (int)region);
+        retval = false;
+    }
+
+    return retval;
+}
+
+static double _seconds(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t max_threads = (argc > 1) ? (uint32_t)atoi(argv[1]) : 8;
+    pthread_t *threads = NULL;
+    struct heap_stats before = {0}, after = {0};
+    size_t initial = 0, remaining = 0;
+    double start = 0, elapsed = 0;
+    int32_t region = -1;
+    int retval = 0;
+
+    /* the key of the thread cache is created by the first heap call, so the key created
+     * after it has its destructor run later */
+    heap_free(heap_malloc(16));
+#ifdef CONFIG_HEAP_THREAD_CACHE
+    heap_thread_cache_flush();
+#endif
+    pthread_key_create(&_late_key, _late_free);
+    region = heap_add_region(_region, sizeof(_region));
+    if(region < 0 || !_bypass_is_right(region)) {
+        retval = 1;
+    }
+    initial = heap_get_free_remaining_size();
+    heap_get_stats(HEAP_REGION_ANY, &before);
+    threads = (pthread_t *)calloc(max_threads, sizeof(pthread_t));
+#ifdef CONFIG_HEAP_THREAD_CACHE
+    printf("engine %s, thread cache\n", HEAP_HOST_ENGINE);
+#else
+    printf("engine %s, no thread cache\n", HEAP_HOST_ENGINE);
+#endif
+    for(uint32_t n = 1; threads && n <= max_threads; n <<= 1) {
+        start = _seconds();
+        for(uint32_t i = 0; i < n; ++i) {
+            pthread_create(&threads[i], NULL, _worker, (void *)(uintptr_t)(i + 1));
+        }
+        for(uint32_t i = 0; i < n; ++i) {
+            pthread_join(threads[i], NULL);
+        }
+        elapsed = _seconds() - start;
+        remaining = heap_get_free_remaining_size();
+        printf("threads %2u: %7.2f Mops/s, %6.1f ns/op per thread, heap %s\n", n,
+               (double)n * OPERATION_COUNT / elapsed / 1e6, elapsed * 1e9 / OPERATION_COUNT,
+               (remaining == initial) ? "whole" : "LEAKED");
+        if(remaining != initial || _corrupted) {
+            retval = 1;
+        }
+    }
+    free(threads);
+    /* the exited threads have added up their cached operations */
+    heap_get_stats(HEAP_REGION_ANY, &after);
+    if((after.alloc_count - before.alloc_count) != atomic_load(&_allocated) ||
+       (after.free_count - before.free_count) != atomic_load(&_allocated)) {
+        printf("FAIL: %u allocations and %u frees counted for %u blocks\n", after.alloc_count - before.alloc_count,
+               after.free_count - before.free_count, atomic_load(&_allocated));
+        retval = 1;
+    }
+    if(retval) {
+        printf("FAIL: %u corrupted blocks, %zu of %zu bytes free\n", (unsigned int)_corrupted,
+               heap_get_free_remaining_size(), initial);
+    }
+
+    return retval;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file tools/host/options_host.h
+ *
+ * Copyright (C) 2024
+ *
+ * options_host.h is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note CONFIG_OPTIONS_FILE of the host builds, the memory comes from the C library and
+ * the critical section is a mutex shared by all threads, the program defines it
+ *
+ * @encoding utf-8
+ */
+#ifndef __OPTIONS_HOST_H
+#define __OPTIONS_HOST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*---------- includes ----------*/
+#include <stdlib.h>
+#include <pthread.h>
+#include "xlog.h"
+
+/*---------- macro ----------*/
+#define __malloc(x)                         malloc(x)
+#define __free(x)                           free(x)
+#define __enter_critical()                  pthread_mutex_lock(&options_host_critical)
+#define __exit_critical()                   pthread_mutex_unlock(&options_host_critical)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+extern pthread_mutex_t options_host_critical;
+
+/*---------- function prototype ----------*/
+extern uint64_t __get_ticks(void);
+#ifdef __cplusplus
+}
+#endif
+#endif /* __OPTIONS_HOST_H */
@@ -0,0 +1,225 @@
+/**
+ * @file tools/host/simple_fifo_bench.c
+ *
+ * Copyright (C) 2024
+ *
+ * simple_fifo_bench.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note throughput of simple_fifo_push() and simple_fifo_pop() for several chunk sizes,
+ * built with the modulo indexes and with CONFIG_SIMPLE_FIFO_POWER_OF_TWO, against the
+ * byte by byte copy the fifo used before. The size queries are called once per chunk
+ * like a UART driver does, the bytes are checked.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "simple_fifo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define FIFO_CAPACITY                       (1024)
+#define TOTAL_BYTES                         (32UL * 1024UL * 1024UL)
+#define CHUNK_MAX                           (256)
+
+/*---------- type define ----------*/
+struct fifo_ops {
+    const char *name;
+    void (*reset)(void *fifo);
+    uint32_t (*push)(void *fifo, const uint8_t *pbuf, uint32_t length);
+    uint32_t (*pop)(void *fifo, uint8_t *pbuf, uint32_t capacity);
+    uint32_t (*get_remaining_size)(void *fifo);
+    uint32_t (*get_available_size)(void *fifo);
+};
+
+/* The fifo before the bulk copy, one byte and one modulo per iteration. */
+struct reference_fifo {
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t tail;
+    uint8_t buf[FIFO_CAPACITY + 1];
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static const uint32_t _chunks[] = {1, 4, 16, 64, 256};
+
+/*---------- function ----------*/
+static double _seconds(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void _reference_reset(void *fifo)
+{
+    struct reference_fifo *self = (struct reference_fifo *)fifo;
+
+    self->capacity = FIFO_CAPACITY + 1;
+    self->head = 0;
+    self->tail = 0;
+}
+
+static uint32_t _reference_get_remaining_size(void *fifo)
+{
+    struct reference_fifo *self = (struct reference_fifo *)fifo;
+    uint32_t full_tail = (self->tail + self->capacity - 1) % self->capacity;
+
+    return ((full_tail + self->capacity - self->head) % self->capacity);
+}
+
+static uint32_t _reference_get_available_size(void *fifo)
+{
+    struct reference_fifo *self = (struct reference_fifo *)fifo;
+
+    return ((self->head + self->capacity - self->tail) % self->capacity);
+}
+
+static uint32_t _reference_push(void *fifo, const uint8_t *pbuf, uint32_t length)
+{
+    struct reference_fifo *self = (struct reference_fifo *)fifo;
+    uint32_t full_tail = (self->tail + self->capacity - 1) % self->capacity, len = 0;
+
+    while(self->head != full_tail && len < length) {
+        self->buf[self->head] = pbuf[len++];
+        self->head = (self->head + 1) % self->capacity;
+    }
+
+    return len;
+}
+
+static uint32_t _reference_pop(void *fifo, uint8_t *pbuf, uint32_t capacity)
+{
+    struct reference_fifo *self = (struct reference_fifo *)fifo;
+    uint32_t len = 0;
+
+    while(self->head != self->tail && len < capacity) {
+        pbuf[len++] = self->buf[self->tail];
+        self->tail = (self->tail + 1) % self->capacity;
+    }
+
+    return len;
+}
+
+static const struct fifo_ops _reference_ops = {
+    .name = "byte loop",
+    .reset = _reference_reset,
+    .push = _reference_push,
+    .pop = _reference_pop,
+    .get_remaining_size = _reference_get_remaining_size,
+    .get_available_size = _reference_get_available_size
+};
+
+static void _simple_fifo_reset(void *fifo)
+{
+    simple_fifo_reset((simple_fifo_t)fifo);
+}
+
+static uint32_t _simple_fifo_get_remaining_size(void *fifo)
+{
+    return simple_fifo_get_remaining_size((simple_fifo_t)fifo);
+}
+
+static uint32_t _simple_fifo_get_available_size(void *fifo)
+{
+    return simple_fifo_get_available_size((simple_fifo_t)fifo);
+}
+
+static uint32_t _simple_fifo_push(void *fifo, const uint8_t *pbuf, uint32_t length)
+{
+    return simple_fifo_push((simple_fifo_t)fifo, pbuf, length);
+}
+
+static uint32_t _simple_fifo_pop(void *fifo, uint8_t *pbuf, uint32_t capacity)
+{
+    return simple_fifo_pop((simple_fifo_t)fifo, pbuf, capacity);
+}
+
+static const struct fifo_ops _simple_fifo_ops = {
+#ifdef CONFIG_SIMPLE_FIFO_POWER_OF_TWO
+    .name = "power of two",
+#else
+    .name = "modulo",
+#endif
+    .reset = _simple_fifo_reset,
+    .push = _simple_fifo_push,
+    .pop = _simple_fifo_pop,
+    .get_remaining_size = _simple_fifo_get_remaining_size,
+    .get_available_size = _simple_fifo_get_available_size
+};
+
+/* The fifo is kept half full, so the chunks cross the end of the storage at every offset. */
+static int _run(const struct fifo_ops *ops, void *fifo, uint32_t chunk)
+{
+    uint8_t in[CHUNK_MAX] = {0}, out[CHUNK_MAX] = {0};
+    uint32_t produced = 0, consumed = 0, n = 0;
+    double start = 0;
+    int retval = 0;
+
+    ops->reset(fifo);
+    for(uint32_t i = 0; i < FIFO_CAPACITY / 2; ++i) {
+        in[0] = (uint8_t)produced++;
+        ops->push(fifo, in, 1);
+    }
+    start = _seconds();
+    while(consumed < TOTAL_BYTES && !retval) {
+        if(ops->get_remaining_size(fifo) >= chunk) {
+            for(uint32_t i = 0; i < chunk; ++i) {
+                in[i] = (uint8_t)(produced + i);
+            }
+            produced += ops->push(fifo, in, chunk);
+        }
+        if(ops->get_available_size(fifo) >= chunk) {
+            n = ops->pop(fifo, out, chunk);
+            for(uint32_t i = 0; i < n; ++i) {
+                if(out[i] != (uint8_t)(consumed + i)) {
+                    printf("FAIL: %s byte %u is 0x%02X, expected 0x%02X\n", ops->name, consumed + i, out[i],
+                           (uint8_t)(consumed + i));
+                    retval = 1;
+                    break;
+                }
+            }
+            consumed += n;
+        }
+    }
+    printf("%-12s chunk %3u: %8.1f MB/s\n", ops->name, chunk, (double)consumed / (_seconds() - start) / 1e6);
+
+    return retval;
+}
+
+int main(void)
+{
+    static struct reference_fifo reference;
+    simple_fifo_t fifo = simple_fifo_new(FIFO_CAPACITY);
+    int retval = 0;
+
+    if(!fifo) {
+        printf("FAIL: no memory for the fifo\n");
+        return 1;
+    }
+    for(uint32_t i = 0; i < sizeof(_chunks) / sizeof(_chunks[0]) && !retval; ++i) {
+        retval = _run(&_reference_ops, &reference, _chunks[i]);
+        retval |= _run(&_simple_fifo_ops, fifo, _chunks[i]);
+    }
+    simple_fifo_delete(fifo);
+
+    return retval;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file tools/host/simple_queue_bench.c
+ *
+ * Copyright (C) 2024
+ *
+ * simple_queue_bench.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note producer/consumer scaling of the CONFIG_SIMPLE_QUEUE_MPMC queue, with single and
+ * with batched push/pop of random sizes. Every member carries its producer and sequence,
+ * a consumer must see the sequence of every producer increase, and every member must be
+ * popped exactly once.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "simple_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*---------- macro ----------*/
+#define QUEUE_MEMBERS                       (1024)
+#define MEMBER_COUNT                        (2000000)
+#define THREADS_MAX                         (64)
+#define BATCH_MAX                           (16)
+#define WATCHDOG_SECONDS                    (120)
+
+/*---------- type define ----------*/
+struct member {
+    uint32_t producer;
+    uint32_t sequence;
+};
+
+struct run {
+    simple_queue_t queue;
+    uint32_t producers;
+    uint32_t consumers;
+    uint32_t per_producer;
+    bool batched;
+    _Atomic uint32_t popped;
+    _Atomic uint32_t errors;
+    _Atomic uint8_t *seen;
+};
+
+struct worker {
+    struct run *prun;
+    uint32_t id;
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+/*---------- function ----------*/
+/* A lost or a duplicated claim leaves the threads waiting for each other forever. */
+static void _watchdog(int signal)
+{
+    static const char message[] = "FAIL: the queue stalled\n";
+
+    (void)signal;
+    write(STDOUT_FILENO, message, sizeof(message) - 1);
+    _exit(1);
+}
+
+static void *_producer(void *arg)
+{
+    struct worker *pworker = (struct worker *)arg;
+    struct run *prun = pworker->prun;
+    struct member members[BATCH_MAX];
+    unsigned int seed = pworker->id + 1;
+    uint32_t sequence = 0, count = 0, n = 0;
+
+    while(sequence < prun->per_producer) {
+        count = prun->batched ? 1 + (uint32_t)rand_r(&seed) % BATCH_MAX : 1;
+        count = (count > prun->per_producer - sequence) ? (prun->per_producer - sequence) : count;
+        for(uint32_t i = 0; i < count; ++i) {
+            members[i].producer = pworker->id;
+            members[i].sequence = sequence + i;
+        }
+        if(prun->batched) {
+            n = simple_queue_push_batch(prun->queue, members, count);
+        } else {
+            n = simple_queue_push(prun->queue, members) ? 1 : 0;
+        }
+        sequence += n;
+        if(!n) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static void *_consumer(void *arg)
+{
+    struct worker *pworker = (struct worker *)arg;
+    struct run *prun = pworker->prun;
+    struct member members[BATCH_MAX];
+    uint32_t last[THREADS_MAX];
+    unsigned int seed = pworker->id + 1000;
+    uint32_t total = prun->producers * prun->per_producer, n = 0;
+    struct member *pmember = NULL;
+
+    memset(last, 0xFF, sizeof(last));
+    while(atomic_load(&prun->popped) < total) {
+        if(prun->batched) {
+            n = simple_queue_pop_batch(prun->queue, members, 1 + (uint32_t)rand_r(&seed) % BATCH_MAX);
+        } else {
+            n = simple_queue_pop(prun->queue, members) ? 1 : 0;
+        }
+        for(uint32_t i = 0; i < n; ++i) {
+            pmember = &members[i];
+            if(pmember->producer >= prun->producers || pmember->sequence >= prun->per_producer ||
+               (last[pmember->producer] != UINT32_MAX && pmember->sequence <= last[pmember->producer]) ||
+               atomic_exchange(&prun->seen[pmember->producer * prun->per_producer + pmember->sequence], 1)) {
+                atomic_fetch_add(&prun->errors, 1);
+                continue;
+            }
+            last[pmember->producer] = pmember->sequence;
+        }
+        atomic_fetch_add(&prun->popped, n);
+        if(!n) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static int _run(uint32_t producers, uint32_t consumers, bool batched)
+{
+    static struct worker workers[THREADS_MAX * 2];
+    static pthread_t threads[THREADS_MAX * 2];
+    struct run run = {0};
+    struct timespec start = {0}, end = {0};
+    uint32_t total = 0, missing = 0;
+    double elapsed = 0;
+
+    run.queue = simple_queue_new(QUEUE_MEMBERS, sizeof(struct member));
+    run.producers = producers;
+    run.consumers = consumers;
+    run.per_producer = MEMBER_COUNT / producers;
+    run.batched = batched;
+    total = run.producers * run.per_producer;
+    run.seen = calloc(total, sizeof(run.seen[0]));
+    if(!run.queue || !run.seen) {
+        printf("FAIL: no memory for the queue\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(uint32_t i = 0; i < producers + consumers; ++i) {
+        workers[i].prun = &run;
+        workers[i].id = (i < producers) ? i : (i - producers);
+        pthread_create(&threads[i], NULL, (i < producers) ? _producer : _consumer, &workers[i]);
+    }
+    for(uint32_t i = 0; i < producers + consumers; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    for(uint32_t i = 0; i < total; ++i) {
+        missing += !atomic_load(&run.seen[i]);
+    }
+    printf("%2u producers %2u consumers %-6s: %6.2f Mmembers/s, %u errors, %u missing\n", producers, consumers,
+           batched ? "batch" : "single", (double)total / elapsed / 1e6, (unsigned int)atomic_load(&run.errors),
+           missing);
+    free((void *)run.seen);
+    simple_queue_delete(run.queue);
+
+    return (atomic_load(&run.errors) || missing) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t max_threads = (argc > 1) ? (uint32_t)atoi(argv[1]) : 4;
+    int retval = 0;
+
+    max_threads = (max_threads > THREADS_MAX) ? THREADS_MAX : max_threads;
+    signal(SIGALRM, _watchdog);
+    alarm(WATCHDOG_SECONDS);
+    for(uint32_t n = 1; n <= max_threads; n <<= 1) {
+        retval |= _run(n, n, false);
+        retval |= _run(n, n, true);
+    }
+
+    return retval;
+}
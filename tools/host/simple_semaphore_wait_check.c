@@ -0,0 +1,103 @@
+/**
+ * @file tools/host/simple_semaphore_wait_check.c
+ *
+ * Copyright (C) 2024
+ *
+ * simple_semaphore_wait_check.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note two threads wait on a binary semaphore with a 50 ms timeout while the main thread
+ * pushes it as soon as it is empty again. The pusher never pauses, so a wait which runs
+ * into its timeout has missed the wakeup of a push.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "simple_semaphore.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define WAITER_COUNT                        (2)
+#define WAIT_COUNT                          (100000)
+#define WAIT_TIMEOUT_MS                     (50)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static simple_semaphore_t _semaphore;
+static _Atomic uint32_t _taken;
+static _Atomic uint32_t _late;
+
+/*---------- function ----------*/
+static uint64_t _now_ms(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000U + (uint64_t)now.tv_nsec / 1000000U;
+}
+
+static void *_waiter(void *arg)
+{
+    uint64_t start = 0;
+
+    while(atomic_load(&_taken) < WAIT_COUNT) {
+        start = _now_ms();
+        if(simple_semaphore_wait(_semaphore, WAIT_TIMEOUT_MS)) {
+            atomic_fetch_add(&_taken, 1);
+        }
+        if(_now_ms() - start >= WAIT_TIMEOUT_MS && atomic_load(&_taken) < WAIT_COUNT) {
+            atomic_fetch_add(&_late, 1);
+        }
+    }
+
+    return arg;
+}
+
+int main(void)
+{
+    pthread_t waiters[WAITER_COUNT];
+    uint32_t pushed = 0;
+
+    _semaphore = simple_semaphore_binary_new();
+    if(!_semaphore) {
+        printf("FAIL: no memory for the semaphore\n");
+        return 1;
+    }
+    for(uint32_t i = 0; i < WAITER_COUNT; ++i) {
+        pthread_create(&waiters[i], NULL, _waiter, NULL);
+    }
+    while(pushed < WAIT_COUNT) {
+        if(simple_semaphore_push(_semaphore)) {
+            pushed++;
+        } else {
+            sched_yield();
+        }
+    }
+    for(uint32_t i = 0; i < WAITER_COUNT; ++i) {
+        pthread_join(waiters[i], NULL);
+    }
+    simple_semaphore_delete(_semaphore);
+    printf("%s: %u waits, %u ran into the timeout\n", atomic_load(&_late) ? "FAIL" : "OK",
+           (unsigned int)atomic_load(&_taken), (unsigned int)atomic_load(&_late));
+
+    return atomic_load(&_late) ? 1 : 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file tools/host/simple_spsc_fifo_stress.c
+ *
+ * Copyright (C) 2024
+ *
+ * simple_spsc_fifo_stress.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note one producer thread and one consumer thread on different cores, both randomly
+ * mix the copying and the zero-copy calls. Byte n of the stream is derived from n, so a
+ * lost, repeated or torn byte is detected by the consumer.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "simple_spsc_fifo.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define FIFO_CAPACITY                       (1000)
+#define PUSH_MAX                            (97)
+#define POP_MAX                             (131)
+#define RESERVE_MAX                         (50)
+#define PEEK_MAX                            (70)
+
+/* Knuth's multiplicative hash, the stream does not repeat within the fifo capacity. */
+#define STREAM_BYTE(n)                      ((uint8_t)(((uint32_t)(n) * 2654435761UL) >> 24))
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static simple_spsc_fifo_t _fifo;
+static uint32_t _total;
+
+/*---------- function ----------*/
+static void *_producer(void *arg)
+{
+    unsigned int seed = 1;
+    uint8_t buf[PUSH_MAX] = {0};
+    uint8_t *pbuf = NULL;
+    uint32_t n = 0, length = 0;
+
+    while(n < _total) {
+        if(rand_r(&seed) & 1) {
+            length = (uint32_t)rand_r(&seed) % PUSH_MAX;
+            length = (length > _total - n) ? (_total - n) : length;
+            for(uint32_t i = 0; i < length; ++i) {
+                buf[i] = STREAM_BYTE(n + i);
+            }
+            n += simple_spsc_fifo_push(_fifo, buf, length);
+        } else {
+            length = simple_spsc_fifo_write_reserve(_fifo, &pbuf);
+            length = (length > RESERVE_MAX) ? RESERVE_MAX : length;
+            length = (length > _total - n) ? (_total - n) : length;
+            for(uint32_t i = 0; i < length; ++i) {
+                pbuf[i] = STREAM_BYTE(n + i);
+            }
+            simple_spsc_fifo_write_commit(_fifo, length);
+            n += length;
+        }
+        if(0 == (rand_r(&seed) & 7)) {
+            sched_yield();
+        }
+    }
+
+    return arg;
+}
+
+static bool _consume(const uint8_t *pbuf, uint32_t length, uint32_t n)
+{
+    bool retval = true;
+
+    for(uint32_t i = 0; i < length && retval; ++i) {
+        if(pbuf[i] != STREAM_BYTE(n + i)) {
+            printf("FAIL: byte %u is 0x%02X, expected 0x%02X\n", n + i, pbuf[i], STREAM_BYTE(n + i));
+            retval = false;
+        }
+    }
+
+    return retval;
+}
+
+int main(int argc, char *argv[])
+{
+    pthread_t producer;
+    unsigned int seed = 2;
+    uint8_t buf[POP_MAX] = {0};
+    const uint8_t *pbuf = NULL;
+    uint32_t n = 0, length = 0;
+    struct timespec start = {0}, end = {0};
+    double elapsed = 0;
+    bool ok = true;
+
+    _total = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 50000000U;
+    _fifo = simple_spsc_fifo_new(FIFO_CAPACITY);
+    if(!_fifo) {
+        printf("FAIL: no memory for the fifo\n");
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&producer, NULL, _producer, NULL);
+    while(n < _total && ok) {
+        if(rand_r(&seed) & 1) {
+            length = simple_spsc_fifo_pop(_fifo, buf, (uint32_t)rand_r(&seed) % POP_MAX);
+            ok = _consume(buf, length, n);
+        } else {
+            length = simple_spsc_fifo_read_peek(_fifo, &pbuf);
+            length = (length > PEEK_MAX) ? PEEK_MAX : length;
+            ok = _consume(pbuf, length, n);
+            simple_spsc_fifo_read_release(_fifo, length);
+        }
+        n += length;
+        if(0 == (rand_r(&seed) & 7)) {
+            sched_yield();
+        }
+    }
+    if(!ok) {
+        /* The producer may wait for space forever, do not join it. */
+        return 1;
+    }
+    pthread_join(producer, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    if(0 != simple_spsc_fifo_get_available_size(_fifo)) {
+        printf("FAIL: %u bytes left in the fifo\n", simple_spsc_fifo_get_available_size(_fifo));
+        ok = false;
+    }
+    printf("%s: %u bytes, %.1f MB/s\n", ok ? "OK" : "FAIL", n, (double)n / elapsed / 1e6);
+    simple_spsc_fifo_delete(_fifo);
+
+    return ok ? 0 : 1;
+}
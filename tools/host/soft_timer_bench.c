@@ -0,0 +1,120 @@
+/**
+ * @file tools/host/soft_timer_bench.c
+ *
+ * Copyright (C) 2024
+ *
+ * soft_timer_bench.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note cost of soft_timer_start(), soft_timer_restart() and soft_timer_tick() with
+ * soft_timer_poll() for 10000 repeat timers, built with the delta list and with
+ * CONFIG_SOFT_TIMER_TIMING_WHEEL. Every timer must expire once per period.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "soft_timer.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define TIMER_COUNT                         (10000)
+#define PERIOD_MAX                          (10000)
+#define TICK_COUNT                          (20000)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+pthread_mutex_t options_host_critical = PTHREAD_MUTEX_INITIALIZER;
+static struct timer_tcb _timers[TIMER_COUNT];
+static uint32_t _order[TIMER_COUNT];
+static uint64_t _expired;
+
+/*---------- function ----------*/
+uint64_t __get_ticks(void)
+{
+    return 0;
+}
+
+static uint64_t _now_ns(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+}
+
+static void _callback(timer_handle_t timer)
+{
+    (void)timer;
+    _expired++;
+}
+
+int main(void)
+{
+    unsigned int seed = 1;
+    uint64_t start = 0, expected = 0;
+    uint32_t k = 0, tmp = 0;
+
+    for(uint32_t i = 0; i < TIMER_COUNT; ++i) {
+        soft_timer_init_static(&_timers[i], "bench", SFTIM_MODE_REPEAT, 1 + (uint32_t)rand_r(&seed) % PERIOD_MAX,
+                               0, NULL, _callback);
+        expected += TICK_COUNT / soft_timer_get_period(&_timers[i]);
+        _order[i] = i;
+    }
+    /* restart the timers in a random order */
+    for(uint32_t i = TIMER_COUNT - 1; i > 0; --i) {
+        k = (uint32_t)rand_r(&seed) % (i + 1);
+        tmp = _order[i];
+        _order[i] = _order[k];
+        _order[k] = tmp;
+    }
+#ifdef CONFIG_SOFT_TIMER_TIMING_WHEEL
+    printf("timing wheel, %u timers\n", TIMER_COUNT);
+#else
+    printf("delta list, %u timers\n", TIMER_COUNT);
+#endif
+    start = _now_ns();
+    for(uint32_t i = 0; i < TIMER_COUNT; ++i) {
+        soft_timer_start(&_timers[i]);
+    }
+    printf("start   %8.1f ns/timer\n", (double)(_now_ns() - start) / TIMER_COUNT);
+    start = _now_ns();
+    for(uint32_t i = 0; i < TIMER_COUNT; ++i) {
+        soft_timer_restart(&_timers[_order[i]]);
+    }
+    printf("restart %8.1f ns/timer\n", (double)(_now_ns() - start) / TIMER_COUNT);
+    start = _now_ns();
+    for(uint32_t i = 0; i < TICK_COUNT; ++i) {
+        soft_timer_tick();
+        soft_timer_poll();
+    }
+    printf("tick    %8.1f ns/tick, %llu expirations\n", (double)(_now_ns() - start) / TICK_COUNT,
+           (unsigned long long)_expired);
+    for(uint32_t i = 0; i < TIMER_COUNT; ++i) {
+        soft_timer_destroy(&_timers[i]);
+    }
+    if(_expired != expected) {
+        printf("FAIL: %llu expirations, expected %llu\n", (unsigned long long)_expired,
+               (unsigned long long)expected);
+        return 1;
+    }
+
+    return 0;
+}
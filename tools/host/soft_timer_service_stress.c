@@ -0,0 +1,121 @@
+/**
+ * @file tools/host/soft_timer_service_stress.c
+ *
+ * Copyright (C) 2024
+ *
+ * soft_timer_service_stress.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note 3000 repeat timers of 1000 objects run on the soft timer service. The callbacks of
+ * one object must never overlap, and after soft_timer_service_stop() every dispatched
+ * callback must have run. The main thread reads the stats of the timers meanwhile.
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "soft_timer.h"
+#include "soft_timer_service.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/*---------- macro ----------*/
+#define OBJECT_COUNT                        (1000)
+#define TIMERS_PER_OBJECT                   (3)
+#define TICK_US                             (1000)
+#define RUN_MS                              (1000)
+
+/*---------- type define ----------*/
+struct object {
+    _Atomic uint32_t busy;
+    uint32_t executed[TIMERS_PER_OBJECT];   /*<< Only changed by the callbacks of the object */
+    struct timer_tcb timers[TIMERS_PER_OBJECT];
+};
+
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+pthread_mutex_t options_host_critical = PTHREAD_MUTEX_INITIALIZER;
+static struct object _objects[OBJECT_COUNT];
+static _Atomic uint32_t _overlapped;
+
+/*---------- function ----------*/
+uint64_t __get_ticks(void)
+{
+    struct timespec now = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000U + (uint64_t)now.tv_nsec / 1000U;
+}
+
+static void _callback(timer_handle_t timer)
+{
+    struct object *pobject = (struct object *)soft_timer_get_user_data(timer);
+
+    if(atomic_fetch_add(&pobject->busy, 1)) {
+        atomic_fetch_add(&_overlapped, 1);
+    }
+    for(volatile uint32_t i = 0; i < 2000; ++i) {
+    }
+    pobject->executed[timer - pobject->timers]++;
+    atomic_fetch_sub(&pobject->busy, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t workers = (argc > 1) ? (uint32_t)atoi(argv[1]) : 4;
+    struct soft_timer_stats stats = {0};
+    uint64_t dispatched = 0, executed = 0, missed = 0, start = 0;
+    uint32_t lost = 0;
+    timer_handle_t timer = NULL;
+
+    for(uint32_t i = 0; i < OBJECT_COUNT; ++i) {
+        for(uint32_t k = 0; k < TIMERS_PER_OBJECT; ++k) {
+            timer = soft_timer_init_static(&_objects[i].timers[k], "stress", SFTIM_MODE_REPEAT,
+                                           1 + (i + k) % 10, 0, &_objects[i], _callback);
+            soft_timer_start(timer);
+        }
+    }
+    if(!soft_timer_service_start(TICK_US, workers)) {
+        printf("FAIL: the service can not start %u workers\n", workers);
+        return 1;
+    }
+    start = __get_ticks();
+    while(__get_ticks() - start < RUN_MS * 1000U) {
+        soft_timer_get_stats(&_objects[rand() % OBJECT_COUNT].timers[0], &stats);
+        usleep(100);
+    }
+    soft_timer_service_stop();
+    for(uint32_t i = 0; i < OBJECT_COUNT; ++i) {
+        for(uint32_t k = 0; k < TIMERS_PER_OBJECT; ++k) {
+            soft_timer_get_stats(&_objects[i].timers[k], &stats);
+            dispatched += stats.dispatch_count;
+            missed += stats.missed_periods;
+            executed += _objects[i].executed[k];
+            lost += (stats.dispatch_count != _objects[i].executed[k]);
+            soft_timer_destroy(&_objects[i].timers[k]);
+        }
+    }
+    /* periods missed on a busy host are not an error, the stats of the timers count them */
+    printf("%s: %u workers, %llu dispatched, %llu executed, %llu periods missed, %u timers lost callbacks, "
+           "%u overlapped\n", (lost || _overlapped) ? "FAIL" : "OK", workers, (unsigned long long)dispatched,
+           (unsigned long long)executed, (unsigned long long)missed, lost, (unsigned int)_overlapped);
+
+    return (lost || _overlapped) ? 1 : 0;
+}
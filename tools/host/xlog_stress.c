@@ -0,0 +1,214 @@
+/**
+ * @file tools/host/xlog_stress.c
+ *
+ * Copyright (C) 2024
+ *
+ * xlog_stress.c is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * @author HinsShum hinsshum@qq.com
+ * @note host stress check of xlog, several threads log numbered messages concurrently
+ * and every message must be printed in the order of its thread or be counted as dropped,
+ * --bench compares the cost of a call of xlog() and xlog_deferred() in the caller
+ *
+ * @encoding utf-8
+ */
+
+/*---------- includes ----------*/
+#include "xlog.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*---------- macro ----------*/
+#define THREAD_COUNT                        (8)
+#define MESSAGE_COUNT                       (20000)
+/* The deferred calls of a batch fit in the ring, it is flushed untimed after each batch. */
+#define BENCH_ROUNDS                        (2000)
+#define BENCH_BATCH                         (32)
+
+/*---------- type define ----------*/
+/*---------- variable prototype ----------*/
+/*---------- function prototype ----------*/
+/*---------- variable ----------*/
+static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+static int32_t _last_seq[THREAD_COUNT];
+static uint32_t _printed;
+static uint32_t _dropped;
+static uint32_t _disorder;
+static char _line[256];
+static uint32_t _line_len;
+static uint32_t _truncated;
+static bool _xlog_only;                     /*<< Only xlog(), set by --xlog-only */
+
+/*---------- function ----------*/
+static void _lock(void)
+{
+    pthread_mutex_lock(&_mutex);
+}
+
+static void _unlock(void)
+{
+    pthread_mutex_unlock(&_mutex);
+}
+
+static void _parse_line(const char *line)
+{
+    const char *p = NULL;
+    int thread = 0, seq = 0;
+    unsigned long dropped = 0;
+
+    if(NULL != (p = strstr(line, "thread ")) && sscanf(p, "thread %d seq %d", &thread, &seq) == 2 &&
+       thread >= 0 && thread < THREAD_COUNT) {
+        if(seq <= _last_seq[thread]) {
+            _disorder++;
+        }
+        _last_seq[thread] = seq;
+        _printed++;
+    } else if(strstr(line, "truncated ") && strstr(line, "...\n")) {
+        _truncated++;
+    } else if(NULL != (p = strstr(line, " logs dropped"))) {
+        /* the number is preceded by the color of the level */
+        while(p > line && p[-1] >= '0' && p[-1] <= '9') {
+            p--;
+        }
+        if(sscanf(p, "%lu", &dropped) == 1) {
+            _dropped += (uint32_t)dropped;
+        }
+    }
+}
+
+/* Called under the lock of xlog, a line may come in several pieces. */
+static void _print(const char *str, uint32_t length)
+{
+    for(uint32_t i = 0; i < length; ++i) {
+        if(_line_len < sizeof(_line) - 1) {
+            _line[_line_len++] = str[i];
+        }
+        if(str[i] == '\n') {
+            _line[_line_len] = '\0';
+            _parse_line(_line);
+            _line_len = 0;
+        }
+    }
+}
+
+static void *_producer(void *arg)
+{
+    int thread = (int)(intptr_t)arg;
+
+    for(int seq = 1; seq <= MESSAGE_COUNT; ++seq) {
+        switch(_xlog_only ? 2 : (seq % 4)) {
+            case 0:
+                xlog_deferred(LOG_INFO "thread %d seq %d\n", thread, seq);
+                break;
+            case 1:
+                xlog_isr(LOG_INFO "thread %d seq %d\n", thread, seq);
+                /* without CONFIG_XLOG_LOCKFREE xlog_isr() discards the message */
+#ifndef CONFIG_XLOG_LOCKFREE
+                xlog(LOG_INFO "thread %d seq %d\n", thread, seq);
+#endif
+                break;
+            default:
+                xlog(LOG_INFO "thread %d seq %d\n", thread, seq);
+                break;
+        }
+    }
+
+    return NULL;
+}
+
+static double _elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+/* The average ns spent by the caller in one call, the deferred records are formatted
+ * and printed by the untimed flush. */
+static double _bench(bool deferred)
+{
+    struct timespec start = {0}, end = {0};
+    double ns = 0;
+
+    for(int round = 0; round < BENCH_ROUNDS; ++round) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(int i = 0; i < BENCH_BATCH; ++i) {
+            if(deferred) {
+                xlog_deferred(LOG_INFO "bench %d %u %s %.2f\n", i, (unsigned)round, "deferred", 1.5);
+            } else {
+                xlog(LOG_INFO "bench %d %u %s %.2f\n", i, (unsigned)round, "xlog", 1.5);
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        ns += _elapsed_ns(&start, &end);
+        (void)xlog_flush();
+    }
+
+    return ns / (BENCH_ROUNDS * BENCH_BATCH);
+}
+
+int main(int argc, char *argv[])
+{
+    xlog_ops_t ops = {0};
+    pthread_t threads[THREAD_COUNT];
+    struct timespec start = {0}, end = {0};
+    uint32_t pushed = THREAD_COUNT * MESSAGE_COUNT;
+    double ns = 0;
+    int retval = 0;
+
+    _xlog_only = (argc > 1 && !strcmp(argv[1], "--xlog-only"));
+    ops.lock = _lock;
+    ops.unlock = _unlock;
+    ops.print = _print;
+    xlog_init(&ops);
+    xlog_set_log_level(LOG_INFO);
+    if(argc > 1 && !strcmp(argv[1], "--bench")) {
+        ns = _bench(false);
+        printf("xlog() %.0f ns/call, xlog_deferred() %.0f ns/call\n", ns, _bench(true));
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < THREAD_COUNT; ++i) {
+        pthread_create(&threads[i], NULL, _producer, (void *)(intptr_t)i);
+    }
+    for(int i = 0; i < THREAD_COUNT; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+    (void)xlog_flush();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    ns = _elapsed_ns(&start, &end);
+    printf("pushed %u printed %u dropped %u disorder %u, %.0f ns/message\n",
+           pushed, _printed, _dropped, _disorder, ns / pushed);
+    if(_printed + _dropped != pushed || _disorder) {
+        printf("FAIL: printed + dropped != pushed or a thread lost its order\n");
+        retval = 1;
+    }
+#ifdef CONFIG_XLOG_DEFERRED
+    /* a string longer than a record is cut, the message must say so */
+    do {
+        char long_str[512] = {0};
+
+        memset(long_str, 'x', sizeof(long_str) - 1);
+        xlog_deferred(LOG_INFO "truncated %s\n", long_str);
+        (void)xlog_flush();
+        if(_truncated != 1) {
+            printf("FAIL: the truncated record is not marked\n");
+            retval = 1;
+        }
+    } while(0);
+#endif
+
+    return retval;
+}